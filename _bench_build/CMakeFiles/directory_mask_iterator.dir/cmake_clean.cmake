@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/directory_mask_iterator.dir/directory_mask_iterator.cpp.o"
+  "CMakeFiles/directory_mask_iterator.dir/directory_mask_iterator.cpp.o.d"
+  "directory_mask_iterator"
+  "directory_mask_iterator.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/directory_mask_iterator.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
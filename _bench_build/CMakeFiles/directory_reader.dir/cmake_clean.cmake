@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/directory_reader.dir/directory_reader.cpp.o"
+  "CMakeFiles/directory_reader.dir/directory_reader.cpp.o.d"
+  "directory_reader"
+  "directory_reader.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/directory_reader.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/mirrored_ring.dir/mirrored_ring.cpp.o"
+  "CMakeFiles/mirrored_ring.dir/mirrored_ring.cpp.o.d"
+  "mirrored_ring"
+  "mirrored_ring.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/mirrored_ring.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/multi_glob.dir/multi_glob.cpp.o"
+  "CMakeFiles/multi_glob.dir/multi_glob.cpp.o.d"
+  "multi_glob"
+  "multi_glob.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/multi_glob.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
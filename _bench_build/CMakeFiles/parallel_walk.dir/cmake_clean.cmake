@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/parallel_walk.dir/parallel_walk.cpp.o"
+  "CMakeFiles/parallel_walk.dir/parallel_walk.cpp.o.d"
+  "parallel_walk"
+  "parallel_walk.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/parallel_walk.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/metrics_reader.dir/metrics_reader.cpp.o"
+  "CMakeFiles/metrics_reader.dir/metrics_reader.cpp.o.d"
+  "metrics_reader"
+  "metrics_reader.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/metrics_reader.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
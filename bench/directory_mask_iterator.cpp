@@ -0,0 +1,73 @@
+// Enumerates a directory of many files by mask, matching file names the
+// way directory_mask_iterator used to (through filename().string()) and
+// through the iterator itself, with the mask given at run time and at build
+// time
+//
+//   directory_mask_iterator [files]
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include <iofet/file.hpp>
+#include <iofet/directory_mask_iterator.hpp>
+
+
+static constexpr char log_mask[] = "*.log";
+
+
+template<typename F> double measure(F&& f) {
+  auto const started = std::chrono::steady_clock::now();
+  f();
+  auto const finished = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(finished - started).count();
+}
+
+
+int main(int argc, char** argv) {
+  namespace fs = std::filesystem;
+  int const files = argc > 1 ? std::atoi(argv[1]) : 100000;
+  int const rounds = 5;
+  fs::path const directory = "bench.directory";
+  fs::create_directory(directory);
+  for(int i = 0; i != files; ++i)
+    iofet::file::touch(directory / ("entry_" + std::to_string(i)
+                                    + (i % 2 ? ".log" : ".idx")));
+
+  std::size_t matched = 0;
+  double const copying = measure([&] {
+    for(int r = 0; r != rounds; ++r) {
+      std::error_code ec;
+      for(fs::directory_iterator it{directory, ec}, last; it != last; it.increment(ec))
+        if(iofet::detail::matched("*.log", it->path().filename().string().data()))
+          ++matched;
+    }
+  });
+
+  double const native = measure([&] {
+    for(int r = 0; r != rounds; ++r) {
+      std::error_code ec;
+      for(iofet::directory_mask_iterator it{directory, "*.log", ec}; it != end(it); ++it)
+        ++matched;
+    }
+  });
+
+  double const fixed = measure([&] {
+    for(int r = 0; r != rounds; ++r) {
+      std::error_code ec;
+      for(iofet::static_directory_mask_iterator<log_mask> it{directory, ec}; it != end(it); ++it)
+        ++matched;
+    }
+  });
+
+  fs::remove_all(directory);
+
+  double const entries = double(files) * rounds;
+  std::cout << "filename().string(): " << entries / copying / 1e6 << " M entries/s\n"
+            << "native names:        " << entries / native / 1e6 << " M entries/s\n"
+            << "static_glob:         " << entries / fixed / 1e6 << " M entries/s\n"
+            << "(matched " << matched << ")" << std::endl;
+  return 0;
+}
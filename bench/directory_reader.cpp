@@ -0,0 +1,82 @@
+// Lists a directory of many files through std::filesystem::directory_iterator,
+// through readdir and through directory_reader one entry or one batch at a
+// time
+//
+//   directory_reader [files]
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include <dirent.h>
+
+#include <iofet/directory_reader.hpp>
+#include <iofet/file.hpp>
+
+
+template<typename F> double measure(F&& f) {
+  auto const started = std::chrono::steady_clock::now();
+  f();
+  auto const finished = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(finished - started).count();
+}
+
+
+int main(int argc, char** argv) {
+  namespace fs = std::filesystem;
+  int const files = argc > 1 ? std::atoi(argv[1]) : 1000000;
+  int const rounds = 5;
+  fs::path const directory = "bench.directory";
+  fs::create_directory(directory);
+  for(int i = 0; i != files; ++i)
+    iofet::file::touch(directory / ("entry_" + std::to_string(i)));
+
+  std::size_t listed = 0;
+  double const standard = measure([&] {
+    for(int r = 0; r != rounds; ++r) {
+      std::error_code ec;
+      for(fs::directory_iterator it{directory, ec}, last; it != last; it.increment(ec))
+        listed += it->is_directory(ec);
+    }
+  });
+
+  double const stream = measure([&] {
+    for(int r = 0; r != rounds; ++r) {
+      DIR* const d = ::opendir(directory.c_str());
+      while(dirent const* e = ::readdir(d))
+        listed += e->d_type == DT_DIR;
+      ::closedir(d);
+    }
+  });
+
+  double const bulk = measure([&] {
+    for(int r = 0; r != rounds; ++r) {
+      auto reader = iofet::directory_reader::open(directory);
+      iofet::directory_reader::entry e;
+      while(reader.next(e))
+        listed += e.type == iofet::directory_reader::entry_type::directory;
+    }
+  });
+
+  double const batched = measure([&] {
+    for(int r = 0; r != rounds; ++r) {
+      auto reader = iofet::directory_reader::open(directory);
+      iofet::directory_reader::entry batch[256];
+      while(std::size_t const n = reader.next_batch(batch))
+        for(std::size_t i = 0; i != n; ++i)
+          listed += batch[i].type == iofet::directory_reader::entry_type::directory;
+    }
+  });
+
+  fs::remove_all(directory);
+
+  double const entries = double(files) * rounds;
+  std::cout << "directory_iterator: " << entries / standard / 1e6 << " M entries/s\n"
+            << "readdir:            " << entries / stream / 1e6 << " M entries/s\n"
+            << "directory_reader:   " << entries / bulk / 1e6 << " M entries/s\n"
+            << "next_batch:         " << entries / batched / 1e6 << " M entries/s\n"
+            << "(" << listed << ")" << std::endl;
+  return 0;
+}
@@ -0,0 +1,112 @@
+// Streams variable sized records through mirrored_ring and through a plain
+// ring that has to split every record crossing its end into two copies.
+// Both read records in place; the plain ring copies out only the records
+// that wrap.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <iofet/mirrored_ring.hpp>
+
+
+class split_ring {
+public:
+  explicit split_ring(std::size_t capacity): data_(capacity) { }
+
+  bool write(char const* data, std::size_t n) noexcept {
+    if(n > data_.size() - (tail_ - head_))
+      return false;
+    std::size_t const offset = tail_ % data_.size();
+    std::size_t const first = std::min(n, data_.size() - offset);
+    std::memcpy(data_.data() + offset, data, first);
+    std::memcpy(data_.data(), data + first, n - first);
+    tail_ += n;
+    return true;
+  }
+
+  // The record in place, or copied into scratch when it wraps
+  char const* read(std::size_t n, char* scratch) noexcept {
+    if(n > tail_ - head_)
+      return nullptr;
+    std::size_t const offset = head_ % data_.size();
+    std::size_t const first = std::min(n, data_.size() - offset);
+    head_ += n;
+    if(first == n)
+      return data_.data() + offset;
+    std::memcpy(scratch, data_.data() + offset, first);
+    std::memcpy(scratch + first, data_.data(), n - first);
+    return scratch;
+  }
+
+private:
+  std::vector<char> data_;
+  std::uint64_t head_{0};
+  std::uint64_t tail_{0};
+};
+
+
+template<typename F> double measure(F&& f) {
+  auto const started = std::chrono::steady_clock::now();
+  f();
+  auto const finished = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(finished - started).count();
+}
+
+
+int main(int, char**) {
+  constexpr std::size_t capacity = 1 << 20;
+  constexpr std::size_t records = 50'000'000;
+  constexpr std::size_t batch = 64;
+
+  char record[256] = {};
+  char sink[256];
+  std::uint64_t checksum = 0;
+
+  auto ring = iofet::mirrored_ring::create("bench.ring", capacity);
+  if(!ring) {
+    std::cerr << iofet::mirrored_ring::last_error().message() << std::endl;
+    return 1;
+  }
+
+  double const mirrored = measure([&] {
+    for(std::size_t i = 0; i < records; i += batch) {
+      for(std::size_t j = 0; j != batch; ++j) {
+        std::size_t const n = 16 + (i + j) % 200;
+        char* const target = ring.prepare(iofet::mirrored_ring::size_type(n));
+        std::memcpy(target, record, n);
+        ring.commit(iofet::mirrored_ring::size_type(n));
+      }
+      for(std::size_t j = 0; j != batch; ++j) {
+        std::size_t const n = 16 + (i + j) % 200;
+        // consumers work in place, no copy out is needed
+        checksum += std::uint8_t(ring.peek()[n - 1]);
+        ring.consume(iofet::mirrored_ring::size_type(n));
+      }
+    }
+  });
+
+  split_ring split{size_t(ring.capacity())};
+  double const copied = measure([&] {
+    for(std::size_t i = 0; i < records; i += batch) {
+      for(std::size_t j = 0; j != batch; ++j)
+        split.write(record, 16 + (i + j) % 200);
+      for(std::size_t j = 0; j != batch; ++j) {
+        std::size_t const n = 16 + (i + j) % 200;
+        char const* const data = split.read(n, sink);
+        checksum += std::uint8_t(data[n - 1]);
+      }
+    }
+  });
+
+  ring = iofet::mirrored_ring{};
+  iofet::file::remove("bench.ring");
+
+  std::cout << "mirrored_ring: " << records / mirrored / 1e6 << " M records/s\n"
+            << "split ring:    " << records / copied / 1e6 << " M records/s\n"
+            << "(checksum " << checksum << ")" << std::endl;
+  return 0;
+}
@@ -0,0 +1,52 @@
+// Walks a tree with a growing number of workers, either an existing one or
+// a generated tree of directories holding a few files each
+//
+//   parallel_walk [root]
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include <iofet/file.hpp>
+#include <iofet/parallel_walk.hpp>
+
+
+template<typename F> double measure(F&& f) {
+  auto const started = std::chrono::steady_clock::now();
+  f();
+  auto const finished = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(finished - started).count();
+}
+
+
+int main(int argc, char** argv) {
+  namespace fs = std::filesystem;
+  bool const generated = argc < 2;
+  fs::path const root = generated ? fs::path{"bench.tree"} : fs::path{argv[1]};
+  if(generated)
+    for(int i = 0; i != 50; ++i)
+      for(int j = 0; j != 50; ++j) {
+        fs::path const directory = root / std::to_string(i) / std::to_string(j);
+        fs::create_directories(directory);
+        for(int k = 0; k != 8; ++k)
+          iofet::file::touch(directory / (std::to_string(k) + (k % 2 ? ".log" : ".idx")));
+      }
+
+  for(unsigned threads: {1u, 2u, 4u, 8u}) {
+    std::atomic<std::size_t> matched{0};
+    double const seconds = measure([&] {
+      iofet::parallel_walk(root, "*.log",
+          [&](unsigned, fs::path const&, auto const& names) {
+            matched.fetch_add(names.size(), std::memory_order_relaxed);
+          }, threads);
+    });
+    std::cout << threads << " threads: " << seconds * 1e3 << " ms (matched "
+              << matched.load() << ")\n";
+  }
+
+  if(generated)
+    fs::remove_all(root);
+  return 0;
+}
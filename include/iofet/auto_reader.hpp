@@ -0,0 +1,171 @@
+/* This file is part of iofet library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+
+#include <cstring>
+#include <filesystem>
+#include <functional>
+
+#include "file.hpp"
+#include "mapped_file.hpp"
+
+
+namespace iofet {
+
+
+// Reads a file either through a mapping or with buffered reads, whichever
+// is expected to be cheaper:
+//   - small files are read, setting up a mapping costs more than copying;
+//   - random access to larger files goes through a mapping;
+//   - sequential scans are mapped only when the file is mostly in the page
+//     cache already, otherwise reads let the kernel issue large requests
+//     instead of faulting page by page.
+class auto_reader {
+public:
+  using size_type = file::size_type;
+  using offset_type = file::offset_type;
+
+  enum class method { mapped, buffered };
+  enum class access { sequential, random };
+
+  struct policy {
+    size_type small_file = 64 * 1024;
+    double cached_enough = 0.5;
+  };
+
+  struct decision {
+    method chosen;
+    access pattern;
+    size_type size;
+    // share of the file in the page cache, negative when unknown
+    double cached;
+  };
+
+  using hook_type = std::function<void(std::filesystem::path const&,
+                                       decision const&)>;
+
+
+  static decision choose(size_type size, access pattern,
+                         std::optional<double> cached) noexcept {
+    return choose(size, pattern, cached, policy{});
+  }
+
+
+  static decision choose(size_type size, access pattern,
+                         std::optional<double> cached,
+                         policy const& rules) noexcept {
+    decision result{method::buffered, pattern, size, cached ? *cached : -1.};
+    if(size <= rules.small_file)
+      return result;
+    if(pattern == access::random || (cached && *cached >= rules.cached_enough))
+      result.chosen = method::mapped;
+    return result;
+  }
+
+
+  static auto_reader open(std::filesystem::path const& path,
+                          access pattern,
+                          hook_type const& hook = hook_type{}) {
+    return open(path, pattern, hook, policy{});
+  }
+
+
+  static auto_reader open(std::filesystem::path const& path,
+                          access pattern,
+                          hook_type const& hook,
+                          policy const& rules) {
+    auto_reader result;
+    result.file_ = file::open_to_read(path);
+    if(!result.file_)
+      return result;
+    auto const size = result.file_.size();
+    if(!size)
+      return result;
+    // residency only matters for large sequential scans
+    std::optional<double> cached;
+    if(*size > rules.small_file && pattern == access::sequential)
+      cached = result.file_.cached_fraction();
+    result.decision_ = choose(*size, pattern, cached, rules);
+    if(result.decision_.chosen == method::mapped && !result.map(path))
+      result.decision_.chosen = method::buffered;
+    if(hook)
+      hook(path, result.decision_);
+    result.opened_ = true;
+    return result;
+  }
+
+
+  static std::error_code last_error() noexcept {
+    return file::last_error();
+  }
+
+
+  auto_reader() noexcept = default;
+  auto_reader(auto_reader const&) = delete;
+  auto_reader& operator = (auto_reader const&) = delete;
+  auto_reader(auto_reader&&) noexcept = default;
+  auto_reader& operator = (auto_reader&&) noexcept = default;
+
+
+  explicit operator bool () const noexcept { return opened_; }
+  decision const& choice() const noexcept { return decision_; }
+  size_type size() const noexcept { return decision_.size; }
+
+
+  // File contents when mapped, nullptr otherwise
+  char const* data() const noexcept { return region_.address; }
+
+
+  bool read(offset_type offset, char* buffer, size_type n) noexcept {
+    if(!opened_ || offset < 0 || n < 0 || offset + n > decision_.size)
+      return false;
+    if(region_) {
+      std::memcpy(buffer, region_.address + offset, size_t(n));
+      return true;
+    }
+    return file_.seek(offset) && file_.read(buffer, n);
+  }
+
+private:
+
+  file file_;
+  mapped_file mapped_;
+  mapped_file::region region_;
+  decision decision_{method::buffered, access::sequential, 0, -1.};
+  bool opened_{false};
+
+
+  bool map(std::filesystem::path const& path) noexcept {
+    mapped_ = mapped_file::open_to_read(path.string());
+    if(!mapped_)
+      return false;
+    region_ = mapped_.map();
+    return !!region_;
+  }
+
+}; // auto_reader
+
+
+} // iofet
@@ -0,0 +1,252 @@
+/* This file is part of iofet library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "directory_reader.hpp"
+#include "glob.hpp"
+#include "metadata_mask_iterator.hpp"
+
+
+namespace iofet {
+
+
+// Names, inodes, sizes and modification times of the entries of a directory
+// matching a mask. Names share one buffer and the records are fixed size,
+// sorted by name. Copies share the listing, so a snapshot refreshed without
+// changes costs nothing to keep or to compare.
+class dir_snapshot {
+public:
+  using string_type = std::filesystem::path::string_type;
+  using name_type = std::basic_string_view<std::filesystem::path::value_type>;
+  using time_point = std::chrono::system_clock::time_point;
+
+  struct entry {
+    name_type name;
+    std::uint64_t inode{0};
+    std::uint64_t size{0};
+    time_point modified;
+  };
+
+
+  static std::optional<dir_snapshot> take(std::filesystem::path const& directory,
+                                          std::string const& mask = "*") {
+    return take(directory, glob{std::filesystem::path{mask}.native()});
+  }
+
+
+  static std::optional<dir_snapshot> take(std::filesystem::path const& directory,
+                                          glob mask) {
+    auto content = std::make_shared<listing>();
+    content->directory = directory;
+    content->mask = std::move(mask);
+    if(!content->read())
+      return std::nullopt;
+    return dir_snapshot{std::move(content)};
+  }
+
+
+  // Snapshot of the same directory now. When the directory's own
+  // modification time has not moved, no entry can have been added, removed
+  // or renamed and the listing is shared with previous instead of read
+  // again; changes made inside files in place are then not seen. A
+  // directory modified within a second of the previous listing is always
+  // read again, as a change in the same timestamp tick would go unnoticed.
+  static std::optional<dir_snapshot> refresh(dir_snapshot const& previous) {
+    auto const modified = modified_time(previous.content_->directory);
+    if(!modified)
+      return std::nullopt;
+    auto const& before = *previous.content_;
+    if(*modified == before.directory_modified &&
+       before.listed - before.directory_modified > std::chrono::seconds{1})
+      return previous;
+    return take(before.directory, before.mask);
+  }
+
+
+  std::filesystem::path const& directory() const noexcept { return content_->directory; }
+  time_point directory_modified() const noexcept { return content_->directory_modified; }
+  std::size_t size() const noexcept { return content_->records.size(); }
+  bool empty() const noexcept { return content_->records.empty(); }
+
+
+  entry operator [] (std::size_t i) const noexcept {
+    return content_->at(i);
+  }
+
+
+  // Whether both are the same listing, as refresh returns when unchanged
+  bool shares(dir_snapshot const& other) const noexcept {
+    return content_ == other.content_;
+  }
+
+private:
+  struct record {
+    std::uint32_t name_offset;
+    std::uint32_t name_size;
+    std::uint64_t inode;
+    std::uint64_t size;
+    time_point::rep modified;
+  };
+
+  struct listing {
+    std::filesystem::path directory;
+    glob mask;
+    time_point directory_modified;
+    time_point listed;
+    string_type names;
+    std::vector<record> records;
+
+
+    entry at(std::size_t i) const noexcept {
+      record const& r = records[i];
+      return entry{name_type{names}.substr(r.name_offset, r.name_size), r.inode, r.size,
+                   time_point{time_point::duration{r.modified}}};
+    }
+
+
+    bool read() {
+      // the directory time goes first so that changes made while listing
+      // make the next refresh read again
+      listed = std::chrono::system_clock::now();
+      auto const modified = modified_time(directory);
+      if(!modified)
+        return false;
+      directory_modified = *modified;
+      auto reader = directory_reader::open(directory);
+      if(!reader)
+        return false;
+
+      std::vector<metadata_entry> found;
+      directory_reader::entry e;
+      while(reader.next(e))
+        if(mask.matches(e.name))
+          found.push_back(metadata_entry{string_type{e.name}, e.type, e.inode, 0, {}});
+      if(!!directory_reader::last_error())
+        return false;
+
+      // stat'ed in inode order, entries removed in between are left out
+      std::sort(found.begin(), found.end(),
+                [](metadata_entry const& a, metadata_entry const& b) { return a.inode < b.inode; });
+      found.erase(std::remove_if(found.begin(), found.end(), [&](metadata_entry& m) {
+        return !detail::fetch_metadata(reader, directory, m, true, true);
+      }), found.end());
+      std::sort(found.begin(), found.end(),
+                [](metadata_entry const& a, metadata_entry const& b) { return a.name < b.name; });
+
+      records.reserve(found.size());
+      for(auto const& m: found) {
+        records.push_back(record{std::uint32_t(names.size()), std::uint32_t(m.name.size()),
+                                 m.inode, m.size, m.modified.time_since_epoch().count()});
+        names += m.name;
+      }
+      return true;
+    }
+  };
+
+  std::shared_ptr<listing const> content_;
+
+
+  explicit dir_snapshot(std::shared_ptr<listing const> content) noexcept:
+    content_{std::move(content)} { }
+
+
+  static std::optional<time_point> modified_time(std::filesystem::path const& path) noexcept {
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if(!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data))
+      return std::nullopt;
+    return detail::from_filetime(data.ftLastWriteTime);
+#else
+    struct stat st;
+    if(::stat(path.c_str(), &st) == -1)
+      return std::nullopt;
+    return detail::from_timespec(st.st_mtim.tv_sec, st.st_mtim.tv_nsec);
+#endif // _WIN32
+  }
+};
+
+
+// Names added, removed and modified (other inode, size or modification
+// time) between two snapshots of a directory
+struct snapshot_changes {
+  std::vector<dir_snapshot::string_type> added;
+  std::vector<dir_snapshot::string_type> removed;
+  std::vector<dir_snapshot::string_type> modified;
+
+  bool empty() const noexcept {
+    return added.empty() && removed.empty() && modified.empty();
+  }
+};
+
+
+// Both snapshots are sorted by name, so this is one merge pass
+inline snapshot_changes diff(dir_snapshot const& before, dir_snapshot const& after) {
+  snapshot_changes result;
+  if(before.shares(after))
+    return result;
+  std::size_t i = 0;
+  std::size_t j = 0;
+  while(i != before.size() || j != after.size()) {
+    if(j == after.size()) {
+      result.removed.emplace_back(before[i++].name);
+      continue;
+    }
+    if(i == before.size()) {
+      result.added.emplace_back(after[j++].name);
+      continue;
+    }
+    auto const old_entry = before[i];
+    auto const new_entry = after[j];
+    if(old_entry.name < new_entry.name) {
+      result.removed.emplace_back(old_entry.name);
+      ++i;
+    } else if(new_entry.name < old_entry.name) {
+      result.added.emplace_back(new_entry.name);
+      ++j;
+    } else {
+      if(old_entry.inode != new_entry.inode || old_entry.size != new_entry.size ||
+         old_entry.modified != new_entry.modified)
+        result.modified.emplace_back(new_entry.name);
+      ++i;
+      ++j;
+    }
+  }
+  return result;
+}
+
+
+} // iofet
@@ -26,6 +26,10 @@
 #include <string>
 #include <filesystem>
 #include <system_error>
+#include <type_traits>
+
+#include "glob.hpp"
+#include "static_glob.hpp"
 
 
 namespace iofet {
@@ -86,69 +90,131 @@ namespace iofet {
       return true;
     }
 
+
+    // File name part of the native path, without a copy
+    inline std::filesystem::path::value_type const*
+    filename_of(std::filesystem::path const& path) noexcept {
+      auto const& native = path.native();
+      auto const* const begin = native.c_str();
+      auto const* name = begin + native.size();
+      while(name != begin) {
+        auto const c = name[-1];
+#ifdef _WIN32
+        if(c == '\\' || c == '/' || c == ':')
+          break;
+#else
+        if(c == '/')
+          break;
+#endif // _WIN32
+        --name;
+      }
+      return name;
+    }
+
   } // detail
 
   
   
-  class directory_mask_iterator {
+  // Matcher is glob when the mask comes at run time, or a static_glob when it
+  // is known at build time so the loop carries no pattern to interpret.
+  template<typename Matcher>
+  class basic_directory_mask_iterator {
   public:
   
     using value_type = std::filesystem::directory_entry;
     using pointer = std::filesystem::directory_entry const*;
     using reference = std::filesystem::directory_entry const&;
     using iterator_category = std::input_iterator_tag;
+    using matcher_type = Matcher;
     
-    directory_mask_iterator() noexcept = default;
-    directory_mask_iterator(directory_mask_iterator const&) = default;
-    directory_mask_iterator& operator = (directory_mask_iterator const&) = default;
-    directory_mask_iterator(directory_mask_iterator&&) = default;
-    directory_mask_iterator& operator = (directory_mask_iterator&&) = default;
+    basic_directory_mask_iterator() noexcept = default;
+    basic_directory_mask_iterator(basic_directory_mask_iterator const&) = default;
+    basic_directory_mask_iterator& operator = (basic_directory_mask_iterator const&) = default;
+    basic_directory_mask_iterator(basic_directory_mask_iterator&&) = default;
+    basic_directory_mask_iterator& operator = (basic_directory_mask_iterator&&) = default;
     
     
-    directory_mask_iterator(std::filesystem::path const& path,
-                            std::string mask,
-                            std::error_code& ec):
+    template<typename M = Matcher,
+             typename = std::enable_if_t<std::is_constructible_v<M, std::filesystem::path::string_type>>>
+    basic_directory_mask_iterator(std::filesystem::path const& path,
+                                  std::string mask,
+                                  std::error_code& ec):
+      basic_directory_mask_iterator{path, Matcher{std::filesystem::path{std::move(mask)}.native()}, ec}
+    { }
+
+
+    template<typename M = Matcher,
+             typename = std::enable_if_t<std::is_empty_v<M>>>
+    basic_directory_mask_iterator(std::filesystem::path const& path,
+                                  std::error_code& ec):
+      basic_directory_mask_iterator{path, Matcher{}, ec}
+    { }
+
+
+    basic_directory_mask_iterator(std::filesystem::path const& path,
+                                  Matcher mask,
+                                  std::error_code& ec):
       it_{path, ec}, mask_{std::move(mask)}
     {
       if (it_ == end(it_))
         return;
-      if (detail::matched(mask_.data(), it_->path().filename().string().data()))
+      if (mask_.matches(detail::filename_of(it_->path())))
         return;
       operator ++ ();
     }
     
     
-    directory_mask_iterator(std::filesystem::path path,
-                            std::filesystem::directory_options options,
-                            std::string mask,
-                            std::error_code& ec):
+    template<typename M = Matcher,
+             typename = std::enable_if_t<std::is_constructible_v<M, std::filesystem::path::string_type>>>
+    basic_directory_mask_iterator(std::filesystem::path path,
+                                  std::filesystem::directory_options options,
+                                  std::string mask,
+                                  std::error_code& ec):
+      basic_directory_mask_iterator{std::move(path), options,
+                                    Matcher{std::filesystem::path{std::move(mask)}.native()}, ec}
+    { }
+
+
+    template<typename M = Matcher,
+             typename = std::enable_if_t<std::is_empty_v<M>>>
+    basic_directory_mask_iterator(std::filesystem::path path,
+                                  std::filesystem::directory_options options,
+                                  std::error_code& ec):
+      basic_directory_mask_iterator{std::move(path), options, Matcher{}, ec}
+    { }
+
+
+    basic_directory_mask_iterator(std::filesystem::path path,
+                                  std::filesystem::directory_options options,
+                                  Matcher mask,
+                                  std::error_code& ec):
       it_{path, options, ec}, mask_{std::move(mask)}
     {
       if (it_ == end(it_))
         return;
-      if (detail::matched(mask_.data(), it_->path().filename().string().data()))
+      if (mask_.matches(detail::filename_of(it_->path())))
         return;
       operator ++ ();
     }
     
     
-    bool operator == (directory_mask_iterator const& other) const noexcept {
+    bool operator == (basic_directory_mask_iterator const& other) const noexcept {
       return it_ == other.it_;
     }
     
     
-    bool operator != (directory_mask_iterator const& other) const noexcept {
+    bool operator != (basic_directory_mask_iterator const& other) const noexcept {
       return it_ != other.it_;
     }
     
     
-    directory_mask_iterator& operator ++ () {
+    basic_directory_mask_iterator& operator ++ () {
       std::error_code ec;
       for(;;) {
         it_.increment(ec);
         if(it_ == end(it_))
           return *this;
-        if(detail::matched(mask_.data(), it_->path().filename().string().data()))
+        if(mask_.matches(detail::filename_of(it_->path())))
           return *this;
       }
     }
@@ -165,17 +231,26 @@ namespace iofet {
     
   private:
     std::filesystem::directory_iterator it_;
-    std::string mask_;
+    // in native encoding to match names as the system returns them
+    Matcher mask_;
   };
+
+
+  using directory_mask_iterator = basic_directory_mask_iterator<glob>;
+
+  template<char const* Mask>
+  using static_directory_mask_iterator = basic_directory_mask_iterator<static_glob<Mask>>;
   
   
-  directory_mask_iterator begin(directory_mask_iterator const& iter) noexcept {
+  template<typename Matcher>
+  basic_directory_mask_iterator<Matcher> begin(basic_directory_mask_iterator<Matcher> const& iter) noexcept {
     return iter;
   }
   
   
-  directory_mask_iterator end(directory_mask_iterator const&) noexcept {
-    return directory_mask_iterator{};
+  template<typename Matcher>
+  basic_directory_mask_iterator<Matcher> end(basic_directory_mask_iterator<Matcher> const&) noexcept {
+    return basic_directory_mask_iterator<Matcher>{};
   }
   
 }
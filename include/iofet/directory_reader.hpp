@@ -0,0 +1,307 @@
+/* This file is part of iofet library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <system_error>
+
+#include "file.hpp"
+
+#ifdef _WIN32
+#include <winbase.h>
+#else
+#include <dirent.h>
+#include <sys/syscall.h>
+#endif // _WIN32
+
+
+namespace iofet {
+
+
+// Reads a directory many entries per system call into one large buffer and
+// hands them out in place: name, type and inode come from the listing itself
+// (getdents64 on Linux, FileIdBothDirectoryInfo on Windows) and nothing is
+// stat'ed unless type_of is asked about an entry of unknown type. Entries
+// stay valid until the next call of next or next_batch.
+class directory_reader {
+public:
+  using char_type = std::filesystem::path::value_type;
+  using name_type = std::basic_string_view<char_type>;
+
+  enum class entry_type : unsigned char {
+    unknown, regular, directory, symlink, block, character, fifo, socket
+  };
+
+  struct entry {
+    name_type name;
+    entry_type type{entry_type::unknown};
+    std::uint64_t inode{0};
+  };
+
+  static constexpr std::size_t default_buffer = 1024 * 1024;
+
+
+  static directory_reader open(std::filesystem::path const& path,
+                               std::size_t buffer_size = default_buffer) {
+    directory_reader result;
+#ifdef _WIN32
+    result.handle_ =
+        CreateFileW(path.c_str(), FILE_LIST_DIRECTORY,
+                    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                    nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if(result.handle_ == INVALID_HANDLE_VALUE)
+      return result;
+#else
+    result.handle_ = ::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(result.handle_ == -1)
+      return result;
+#endif // _WIN32
+    result.buffer_.reset(new char[buffer_size]);
+    result.capacity_ = buffer_size;
+    return result;
+  }
+
+
+  static std::error_code last_error() noexcept {
+    return file::last_error();
+  }
+
+
+  directory_reader() noexcept = default;
+  directory_reader(directory_reader const&) = delete;
+  directory_reader& operator = (directory_reader const&) = delete;
+
+  directory_reader(directory_reader&& source) noexcept {
+    swap(source);
+  }
+
+  directory_reader& operator = (directory_reader&& source) noexcept {
+    directory_reader moved{std::move(source)};
+    swap(moved);
+    return *this;
+  }
+
+  ~directory_reader() noexcept {
+#ifdef _WIN32
+    if(handle_ != INVALID_HANDLE_VALUE)
+      CloseHandle(handle_);
+#else
+    if(handle_ != -1)
+      ::close(handle_);
+#endif // _WIN32
+  }
+
+
+#ifdef _WIN32
+  explicit operator bool () const noexcept { return handle_ != INVALID_HANDLE_VALUE; }
+  HANDLE native_handle() const noexcept { return handle_; }
+#else
+  explicit operator bool () const noexcept { return handle_ != -1; }
+  // The directory descriptor, for *at calls relative to it
+  int native_handle() const noexcept { return handle_; }
+#endif // _WIN32
+
+
+  // Fills result with the next entry other than "." and "..", false at the
+  // end of the directory or on error (last_error tells them apart)
+  bool next(entry& result) noexcept {
+    for(;;) {
+      if(decode(result))
+        return true;
+      if(!fill())
+        return false;
+    }
+  }
+
+
+  // Fills up to count entries from one kernel buffer and returns how many,
+  // 0 at the end of the directory or on error. All of them stay valid until
+  // the next call, so a batch can be handed over as a whole.
+  std::size_t next_batch(entry* entries, std::size_t count) noexcept {
+    if(count == 0)
+      return 0;
+    std::size_t n = 0;
+    while(n == 0) {
+      if(position_ == size_ && !fill())
+        return 0;
+      while(n != count && decode(entries[n]))
+        ++n;
+    }
+    return n;
+  }
+
+
+  template<std::size_t N>
+  std::size_t next_batch(entry (&entries)[N]) noexcept {
+    return next_batch(entries, N);
+  }
+
+
+  // Type of e, from a stat relative to the directory when the listing did
+  // not tell
+  entry_type type_of(entry const& e) const noexcept {
+#ifdef _WIN32
+    return e.type;
+#else
+    if(e.type != entry_type::unknown)
+      return e.type;
+    // names from getdents64 are NUL terminated in the buffer
+    struct stat st;
+    if(::fstatat(handle_, e.name.data(), &st, AT_SYMLINK_NOFOLLOW) == -1)
+      return entry_type::unknown;
+    switch(st.st_mode & S_IFMT) {
+      case S_IFREG: return entry_type::regular;
+      case S_IFDIR: return entry_type::directory;
+      case S_IFLNK: return entry_type::symlink;
+      case S_IFBLK: return entry_type::block;
+      case S_IFCHR: return entry_type::character;
+      case S_IFIFO: return entry_type::fifo;
+      case S_IFSOCK: return entry_type::socket;
+      default: return entry_type::unknown;
+    }
+#endif // _WIN32
+  }
+
+private:
+#ifdef _WIN32
+  HANDLE handle_{INVALID_HANDLE_VALUE};
+  bool restarted_{false};
+#else
+  int handle_{-1};
+#endif // _WIN32
+  std::unique_ptr<char[]> buffer_;
+  std::size_t capacity_{0};
+  std::size_t size_{0};
+  std::size_t position_{0};
+  bool finished_{false};
+
+#ifndef _WIN32
+  // struct linux_dirent64 { u64 d_ino; s64 d_off; u16 d_reclen; u8 d_type; char d_name[]; }
+  static constexpr std::size_t inode_offset = 0;
+  static constexpr std::size_t length_offset = 16;
+  static constexpr std::size_t type_offset = 18;
+  static constexpr std::size_t name_offset = 19;
+
+
+  static entry_type type_from(unsigned char type) noexcept {
+    switch(type) {
+      case DT_REG: return entry_type::regular;
+      case DT_DIR: return entry_type::directory;
+      case DT_LNK: return entry_type::symlink;
+      case DT_BLK: return entry_type::block;
+      case DT_CHR: return entry_type::character;
+      case DT_FIFO: return entry_type::fifo;
+      case DT_SOCK: return entry_type::socket;
+      default: return entry_type::unknown;
+    }
+  }
+#endif // _WIN32
+
+
+  // Next entry left in the buffer other than "." and ".."
+  bool decode(entry& result) noexcept {
+    while(position_ != size_) {
+#ifdef _WIN32
+      auto const* const info =
+          reinterpret_cast<FILE_ID_BOTH_DIR_INFO const*>(buffer_.get() + position_);
+      position_ = info->NextEntryOffset == 0 ? size_ : position_ + info->NextEntryOffset;
+      result.name = name_type{info->FileName, info->FileNameLength / sizeof(wchar_t)};
+      result.inode = std::uint64_t(info->FileId.QuadPart);
+      result.type = (info->FileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) ? entry_type::symlink
+                  : (info->FileAttributes & FILE_ATTRIBUTE_DIRECTORY) ? entry_type::directory
+                  : entry_type::regular;
+#else
+      auto const* const record = buffer_.get() + position_;
+      std::uint64_t inode;
+      unsigned short length;
+      std::memcpy(&inode, record + inode_offset, sizeof(inode));
+      std::memcpy(&length, record + length_offset, sizeof(length));
+      position_ += length;
+      char const* const text = record + name_offset;
+      result.name = name_type{text};
+      result.inode = inode;
+      result.type = type_from(static_cast<unsigned char>(record[type_offset]));
+#endif // _WIN32
+      auto const& name = result.name;
+      if(name.size() <= 2 && name[0] == '.' && (name.size() == 1 || name[1] == '.'))
+        continue;
+      return true;
+    }
+    return false;
+  }
+
+
+  bool fill() noexcept {
+    position_ = size_ = 0;
+    if(finished_ || !buffer_)
+      return false;
+#ifdef _WIN32
+    FILE_INFO_BY_HANDLE_CLASS const request =
+        restarted_ ? FileIdBothDirectoryInfo : FileIdBothDirectoryRestartInfo;
+    restarted_ = true;
+    if(!GetFileInformationByHandleEx(handle_, request, buffer_.get(), DWORD(capacity_))) {
+      finished_ = true;
+      if(GetLastError() == ERROR_NO_MORE_FILES)
+        SetLastError(ERROR_SUCCESS);
+      return false;
+    }
+    size_ = capacity_;
+#else
+    long n;
+    do
+      n = ::syscall(SYS_getdents64, handle_, buffer_.get(), capacity_);
+    while(n == -1 && errno == EINTR);
+    if(n <= 0) {
+      finished_ = true;
+      if(n == 0)
+        errno = 0;
+      return false;
+    }
+    size_ = std::size_t(n);
+#endif // _WIN32
+    return true;
+  }
+
+
+  void swap(directory_reader& other) noexcept {
+    std::swap(handle_, other.handle_);
+#ifdef _WIN32
+    std::swap(restarted_, other.restarted_);
+#endif // _WIN32
+    std::swap(buffer_, other.buffer_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(size_, other.size_);
+    std::swap(position_, other.position_);
+    std::swap(finished_, other.finished_);
+  }
+};
+
+
+} // iofet
@@ -24,9 +24,13 @@
 
 
 #include <cstdint>
+#include <cstring>
 #include <system_error>
 #include <filesystem>
+#include <memory>
 #include <optional>
+#include <string>
+#include <vector>
 
 
 #ifdef _WIN32
@@ -44,14 +48,19 @@
 #endif
 
 #include <minwindef.h>
+#include <minwinbase.h>
 #include <errhandlingapi.h>
 #include <fileapi.h>
 #include <handleapi.h>
 #include <sysinfoapi.h>
 
 #else
-  
-#error Unsupported system
+
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #endif // WIN32
 
@@ -62,10 +71,21 @@ namespace iofet {
 class file {
 public:
   friend class mapped_file;
+  friend class growable_mapping;
+  friend class mirrored_ring;
 
   using size_type = std::int64_t;
   using offset_type = std::int64_t;
 
+  // Largest single read or write request passed to the system
+  static constexpr size_type max_chunk = size_type(1) << 30;
+
+  // Uninitialized storage for read_all
+  struct contents {
+    std::unique_ptr<char[]> data;
+    size_type size{0};
+  };
+
 
 #if defined(_WIN32)
 
@@ -208,20 +228,50 @@ public:
   }
 
 
-  bool read(char* buffer, size_type size) noexcept {
+  // Reads up to size bytes: returns 0 at the end of file and -1 on error
+  size_type read_some(char* buffer, size_type size) noexcept {
     DWORD n;
-    bool const ok = ReadFile(handle_, buffer, static_cast<DWORD>(size), &n, nullptr);
-    if(!ok || n != static_cast<DWORD>(size))
-      return false;
+    DWORD const chunk = static_cast<DWORD>(size < max_chunk ? size : max_chunk);
+    if(!ReadFile(handle_, buffer, chunk, &n, nullptr))
+      return -1;
+    return n;
+  }
+
+
+  bool read(char* buffer, size_type size) noexcept {
+    while(size > 0) {
+      size_type const n = read_some(buffer, size);
+      if(n <= 0)
+        return false;
+      buffer += n;
+      size -= n;
+    }
     return true;
   }
 
 
-  bool write(char const* buffer, size_type size) noexcept {
+  // Positional read_some, the file pointer is not meant to be used with it
+  size_type read_some_at(offset_type offset, char* buffer, size_type size) noexcept {
+    OVERLAPPED overlapped{};
+    overlapped.Offset = static_cast<DWORD>(offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
     DWORD n;
-    bool const ok = WriteFile(handle_, buffer, static_cast<DWORD>(size), &n, nullptr);
-    if(!ok || n != static_cast<DWORD>(size))
-      return false;
+    DWORD const chunk = static_cast<DWORD>(size < max_chunk ? size : max_chunk);
+    if(!ReadFile(handle_, buffer, chunk, &n, &overlapped))
+      return GetLastError() == ERROR_HANDLE_EOF ? 0 : -1;
+    return n;
+  }
+
+
+  bool write(char const* buffer, size_type size) noexcept {
+    while(size > 0) {
+      DWORD n;
+      DWORD const chunk = static_cast<DWORD>(size < max_chunk ? size : max_chunk);
+      if(!WriteFile(handle_, buffer, chunk, &n, nullptr) || n == 0)
+        return false;
+      buffer += n;
+      size -= n;
+    }
     return true;
   }
 
@@ -246,6 +296,12 @@ public:
     return true;
   }
 
+
+  // Windows has no query for pages of a file in the system cache
+  std::optional<double> cached_fraction() const {
+    return std::nullopt;
+  }
+
 private:
 
   handle_type handle_{INVALID_HANDLE_VALUE};
@@ -255,32 +311,57 @@ private:
   
   using handle_type = int;
 
-  static file create(std::string path) noexcept {
-    int const handle = ::open(path.data(), O_CREAT | O_RDWR | O_TRUNC,
+  static file create(std::filesystem::path const& path) noexcept {
+    int const handle = ::open(path.c_str(), O_CREAT | O_RDWR | O_TRUNC,
                               S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
     return file{handle};
   }
 
 
-  static file open_to_append(std::string path) noexcept {
-    int const handle = ::open(path.data(), O_WRONLY);
+  static file open_to_append(std::filesystem::path const& path) noexcept {
+    int const handle = ::open(path.c_str(), O_WRONLY);
     if(handle == -1)
-      return file{handle}
+      return file{handle};
     lseek(handle, 0, SEEK_END);
     return file{handle};
   }
 
 
-  static file open_to_read(std::string path) noexcept {
-    int const handle = ::open(path.data(), O_RDONLY);
+  static file open_to_read(std::filesystem::path const& path) noexcept {
+    int const handle = ::open(path.c_str(), O_RDONLY);
     return file{handle};
   }
 
 
-  static file open_to_rw(std::string path) noexcept {
-    int const handle = ::open(path.data(), O_RDWR);
+  static file open_to_rw(std::filesystem::path const& path) noexcept {
+    int const handle = ::open(path.c_str(), O_RDWR);
     return file{handle};
   }
+
+
+  static bool touch(std::filesystem::path const& path) noexcept {
+    int const handle = ::open(path.c_str(), O_CREAT | O_WRONLY,
+                              S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if(handle == -1)
+      return false;
+    bool const updated = futimens(handle, nullptr) == 0;
+    ::close(handle);
+    return updated;
+  }
+
+
+  static bool remove(std::filesystem::path const& path) noexcept {
+    return ::unlink(path.c_str()) == 0;
+  }
+
+
+  static bool used_by(std::filesystem::path const& path) noexcept {
+    int const handle = ::open(path.c_str(), O_RDONLY);
+    if(handle == -1)
+      return true;
+    ::close(handle);
+    return false;
+  }
   
   
   static std::error_code last_error() noexcept {
@@ -313,20 +394,74 @@ private:
   }
 
 
+  std::optional<size_type> size() const noexcept {
+    std::optional<size_type> result;
+    struct stat st;
+    if(fstat(handle_, &st) == -1)
+      return result;
+    return result = size_type(st.st_size);
+  }
+
+
+  // Reads up to size bytes: returns 0 at the end of file and -1 on error
+  size_type read_some(char* buffer, size_type size) noexcept {
+    size_t const chunk = size_t(size < max_chunk ? size : max_chunk);
+    for(;;) {
+      ssize_t const n = ::read(handle_, buffer, chunk);
+      if(n != -1 || errno != EINTR)
+        return n;
+    }
+  }
+
+
   bool read(char* buffer, size_type size) noexcept {
-    size_type const n = ::read(handle_, buffer, size);
-    if(n != size)
-      return false;
+    while(size > 0) {
+      size_type const n = read_some(buffer, size);
+      if(n <= 0)
+        return false;
+      buffer += n;
+      size -= n;
+    }
     return true;
   }
     
 
+  // Positional read_some, safe to call from several threads at once
+  size_type read_some_at(offset_type offset, char* buffer, size_type size) noexcept {
+    size_t const chunk = size_t(size < max_chunk ? size : max_chunk);
+    for(;;) {
+      ssize_t const n = ::pread(handle_, buffer, chunk, off_t(offset));
+      if(n != -1 || errno != EINTR)
+        return n;
+    }
+  }
+
+
   bool write(char const* buffer, size_type size) noexcept {
-    size_type const n = ::write(handle_, buffer, size);
-    if(n != size)
-      return false;
+    while(size > 0) {
+      size_t const chunk = size_t(size < max_chunk ? size : max_chunk);
+      ssize_t const n = ::write(handle_, buffer, chunk);
+      if(n == -1 && errno == EINTR)
+        continue;
+      if(n <= 0)
+        return false;
+      buffer += n;
+      size -= n;
+    }
     return true;
   }
+
+
+  template<typename T>
+  bool binary_read(T& buffer) noexcept {
+    return read(reinterpret_cast<char*>(&buffer), sizeof(T));
+  }
+
+
+  template<typename T>
+  bool binary_write(T const& buffer) noexcept {
+    return write(reinterpret_cast<char const*>(&buffer), sizeof(T));
+  }
   
 
   bool resize(size_type size) noexcept {
@@ -334,12 +469,132 @@ private:
       return false;
     return true;
   }
+
+
+  bool seek(offset_type offset) noexcept {
+    return lseek(handle_, static_cast<off_t>(offset), SEEK_SET) != -1;
+  }
+
+
+  // Share of the file pages held in the page cache, the file has to be readable
+  std::optional<double> cached_fraction() const {
+    std::optional<double> result;
+    auto const total = size();
+    if(!total)
+      return result;
+    if(*total == 0)
+      return result = 1.;
+    size_type const page = sysconf(_SC_PAGESIZE);
+    constexpr size_type chunk = size_type(1) << 30;
+    size_type resident = 0;
+    std::vector<unsigned char> pages;
+    for(offset_type offset = 0; offset < *total; offset += chunk) {
+      size_type const n = *total - offset < chunk ? *total - offset : chunk;
+      void* const address = ::mmap(nullptr, size_t(n), PROT_READ, MAP_SHARED,
+                                   handle_, off_t(offset));
+      if(address == MAP_FAILED)
+        return result;
+      pages.resize(size_t((n + page - 1) / page));
+      int const rc = ::mincore(address, size_t(n), pages.data());
+      ::munmap(address, size_t(n));
+      if(rc == -1)
+        return result;
+      for(unsigned char p: pages)
+        resident += p & 1;
+    }
+    return result = double(resident) / double((*total + page - 1) / page);
+  }
   
 private:
 
   handle_type handle_{-1};
   
 #endif // _WIN32
+
+public:
+
+  bool read_at(offset_type offset, char* buffer, size_type size) noexcept {
+    while(size > 0) {
+      size_type const n = read_some_at(offset, buffer, size);
+      if(n <= 0)
+        return false;
+      offset += n;
+      buffer += n;
+      size -= n;
+    }
+    return true;
+  }
+
+
+  // Whole file in storage that is allocated once and not zeroed. The size
+  // comes from a single stat; files reporting 0, like those in /proc, are
+  // read in chunks until the end.
+  static std::optional<contents> read_all(std::filesystem::path const& path) {
+    std::optional<contents> result;
+    file f = open_to_read(path);
+    if(!f)
+      return result;
+    auto const expected = f.size();
+    if(!expected)
+      return result;
+    contents target;
+    size_type capacity = *expected > 0 ? *expected : initial_chunk;
+    target.data.reset(new char[size_t(capacity)]);
+    for(;;) {
+      size_type const n = f.read_some(target.data.get() + target.size,
+                                      capacity - target.size);
+      if(n < 0)
+        return result;
+      target.size += n;
+      if(n == 0 || target.size == *expected)
+        break;
+      if(target.size == capacity) {
+        std::unique_ptr<char[]> grown{new char[size_t(2 * capacity)]};
+        std::memcpy(grown.get(), target.data.get(), size_t(target.size));
+        target.data = std::move(grown);
+        capacity *= 2;
+      }
+    }
+    result = std::move(target);
+    return result;
+  }
+
+
+  // Whole file in a string using allocator, e.g. std::pmr::string with
+  // std::pmr::polymorphic_allocator<char>
+  template<typename Allocator>
+  static std::optional<std::basic_string<char, std::char_traits<char>, Allocator>>
+  read_all(std::filesystem::path const& path, Allocator const& allocator) {
+    std::optional<std::basic_string<char, std::char_traits<char>, Allocator>> result;
+    file f = open_to_read(path);
+    if(!f)
+      return result;
+    auto const expected = f.size();
+    if(!expected)
+      return result;
+    std::basic_string<char, std::char_traits<char>, Allocator> target{allocator};
+    target.resize(size_t(*expected > 0 ? *expected : initial_chunk));
+    size_type size = 0;
+    for(;;) {
+      size_type const n = f.read_some(target.data() + size,
+                                      size_type(target.size()) - size);
+      if(n < 0)
+        return result;
+      size += n;
+      if(n == 0 || size == *expected)
+        break;
+      if(size == size_type(target.size()))
+        target.resize(2 * target.size());
+    }
+    target.resize(size_t(size));
+    result = std::move(target);
+    return result;
+  }
+
+private:
+
+  static constexpr size_type initial_chunk = 64 * 1024;
+
 }; // file
 
   
@@ -0,0 +1,251 @@
+/* This file is part of iofet library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace iofet {
+
+
+// File name mask with '*' and '?' wildcards compiled once for repeated
+// matching. Common shapes (exact name, "prefix*", "*suffix", "*part*") are
+// plain string compares. Other masks are split by '*' into segments that
+// are placed leftmost one after another: with only these two wildcards
+// that placement never has to be undone, so there is no backtracking.
+// Before that, names too short or lacking the longest literal of the mask
+// are rejected.
+template<typename C>
+class basic_glob {
+public:
+  using value_type = C;
+  using string_type = std::basic_string<C>;
+  using view_type = std::basic_string_view<C>;
+
+  enum class kind { exact, prefix, suffix, contains, general };
+
+
+  basic_glob() noexcept = default;
+
+  explicit basic_glob(string_type mask): mask_{std::move(mask)} {
+    compile();
+  }
+
+
+  string_type const& mask() const noexcept { return mask_; }
+  kind classification() const noexcept { return kind_; }
+
+  // Longest literal run every matching name contains, may be empty
+  view_type required_literal() const noexcept { return literal(); }
+
+
+  bool matches(view_type text) const noexcept {
+    switch(kind_) {
+      case kind::exact:
+        return text == literal();
+      case kind::prefix:
+        return text.size() >= literal_.size &&
+               text.compare(0, literal_.size, literal()) == 0;
+      case kind::suffix:
+        return text.size() >= literal_.size &&
+               text.compare(text.size() - literal_.size, literal_.size, literal()) == 0;
+      case kind::contains:
+        return text.find(literal()) != view_type::npos;
+      default:
+        return matches_segments(text);
+    }
+  }
+
+
+  bool matches(C const* text) const noexcept {
+    return matches(view_type{text});
+  }
+
+
+  bool operator () (view_type text) const noexcept {
+    return matches(text);
+  }
+
+private:
+
+  struct span_type {
+    std::size_t offset{0};
+    std::size_t size{0};
+  };
+
+  struct segment_type {
+    span_type span;
+    bool wild{false}; // has '?'
+  };
+
+  string_type mask_;
+  kind kind_{kind::exact};
+  // the literal of the plain kinds, the longest literal run for general
+  span_type literal_;
+  std::vector<segment_type> segments_;
+  std::size_t min_size_{0};
+  bool star_{false};
+  bool anchored_front_{true};
+  bool anchored_back_{true};
+
+
+  view_type view(span_type span) const noexcept {
+    return view_type{mask_}.substr(span.offset, span.size);
+  }
+
+
+  view_type literal() const noexcept {
+    return view(literal_);
+  }
+
+
+  void compile() {
+    view_type const mask{mask_};
+    std::size_t const size = mask.size();
+    star_ = mask.find(C('*')) != view_type::npos;
+    anchored_front_ = size == 0 || mask.front() != C('*');
+    anchored_back_ = size == 0 || mask.back() != C('*');
+
+    for(std::size_t i = 0; i < size;) {
+      if(mask[i] == C('*')) {
+        ++i;
+        continue;
+      }
+      segment_type segment;
+      segment.span.offset = i;
+      while(i < size && mask[i] != C('*')) {
+        segment.wild = segment.wild || mask[i] == C('?');
+        ++i;
+      }
+      segment.span.size = i - segment.span.offset;
+      min_size_ += segment.span.size;
+      segments_.push_back(segment);
+    }
+
+    bool const wild = mask.find(C('?')) != view_type::npos;
+    if(!wild && segments_.size() <= 1) {
+      span_type const only = segments_.empty() ? span_type{} : segments_[0].span;
+      literal_ = only;
+      if(!star_)
+        kind_ = kind::exact;
+      else if(anchored_front_)
+        kind_ = kind::prefix;
+      else if(anchored_back_)
+        kind_ = kind::suffix;
+      else
+        kind_ = kind::contains;
+      // "*" alone is a prefix of every name
+      if(only.size == 0 && star_)
+        kind_ = kind::prefix;
+      return;
+    }
+
+    kind_ = kind::general;
+    for(auto const& segment: segments_)
+      for(std::size_t i = segment.span.offset, end = i + segment.span.size; i < end;) {
+        if(mask[i] == C('?')) {
+          ++i;
+          continue;
+        }
+        span_type run{i, 0};
+        while(i < end && mask[i] != C('?'))
+          ++i;
+        run.size = i - run.offset;
+        if(run.size > literal_.size)
+          literal_ = run;
+      }
+  }
+
+
+  bool matches_at(segment_type const& segment, view_type text,
+                  std::size_t position) const noexcept {
+    view_type const pattern = view(segment.span);
+    if(!segment.wild)
+      return text.compare(position, pattern.size(), pattern) == 0;
+    for(std::size_t i = 0; i != pattern.size(); ++i)
+      if(pattern[i] != C('?') && pattern[i] != text[position + i])
+        return false;
+    return true;
+  }
+
+
+  // Leftmost position of segment in text[from, to) or npos
+  std::size_t find(segment_type const& segment, view_type text,
+                   std::size_t from, std::size_t to) const noexcept {
+    std::size_t const size = segment.span.size;
+    if(!segment.wild)
+      return text.substr(0, to).find(view(segment.span), from);
+    for(std::size_t position = from; position + size <= to; ++position)
+      if(matches_at(segment, text, position))
+        return position;
+    return view_type::npos;
+  }
+
+
+  bool matches_segments(view_type text) const noexcept {
+    if(!star_)
+      return text.size() == min_size_ && matches_at(segments_[0], text, 0);
+    if(text.size() < min_size_)
+      return false;
+    if(literal_.size != 0 && text.find(literal()) == view_type::npos)
+      return false;
+
+    std::size_t first = 0;
+    std::size_t last = segments_.size();
+    std::size_t from = 0;
+    std::size_t to = text.size();
+    if(anchored_front_) {
+      if(!matches_at(segments_[first], text, 0))
+        return false;
+      from = segments_[first++].span.size;
+    }
+    if(anchored_back_) {
+      segment_type const& back = segments_[--last];
+      if(!matches_at(back, text, text.size() - back.span.size))
+        return false;
+      to = text.size() - back.span.size;
+    }
+    if(from > to)
+      return false;
+    for(std::size_t i = first; i < last; ++i) {
+      std::size_t const found = find(segments_[i], text, from, to);
+      if(found == view_type::npos)
+        return false;
+      from = found + segments_[i].span.size;
+    }
+    return true;
+  }
+
+}; // basic_glob
+
+
+using glob = basic_glob<std::filesystem::path::value_type>;
+
+
+} // iofet
@@ -0,0 +1,286 @@
+/* This file is part of iofet library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+#include "file.hpp"
+#include "mapped_file.hpp"
+
+
+#ifdef _WIN32
+
+#if !defined(_X86_) && !defined(_AMD64_) && !defined(_ARM_) && !defined(_ARM64_)
+#if defined(_M_IX86)
+#define _X86_
+#elif defined(_M_AMD64)
+#define _AMD64_
+#elif defined(_M_ARM)
+#define _ARM_
+#elif defined(_M_ARM64)
+#define _ARM64_
+#endif
+#endif
+
+#include <minwindef.h>
+#include <memoryapi.h>
+#include <handleapi.h>
+#include <processthreadsapi.h>
+
+#pragma comment(lib, "onecore.lib")
+
+#else
+
+#include <sys/mman.h>
+
+#endif // WIN32
+
+
+namespace iofet {
+
+
+// Memory mapping of a file that grows in place: the whole capacity is reserved
+// as inaccessible address space up front and file-backed pages are committed
+// into it step by step, so data() never moves while the file grows.
+class growable_mapping {
+public:
+  using size_type = long long;
+
+  static constexpr size_type default_step = 64 * 1024 * 1024;
+
+
+  static growable_mapping open(std::filesystem::path const& path,
+                               size_type capacity,
+                               size_type step = default_step) noexcept {
+    growable_mapping result;
+    result.file_ = file::open_to_rw(path);
+    if(!result.file_)
+      return result;
+    auto const size = result.file_.size();
+    if(!size)
+      return result;
+    result.step_ = round_up(step, mapped_file::granularity());
+    result.capacity_ = round_up(capacity, result.step_);
+    if(*size > result.capacity_)
+      return result;
+    if(!result.reserve())
+      return result;
+    result.size_ = *size;
+    if(!result.commit(round_up(*size, result.step_)))
+      result.close();
+    return result;
+  }
+
+
+  static std::error_code last_error() noexcept {
+    return file::last_error();
+  }
+
+
+  growable_mapping() noexcept = default;
+  ~growable_mapping() noexcept { close(); }
+  growable_mapping(growable_mapping const&) = delete;
+  growable_mapping& operator = (growable_mapping const&) = delete;
+
+
+  growable_mapping(growable_mapping&& other) noexcept:
+    file_{std::move(other.file_)}, base_{other.base_},
+    size_{other.size_}, committed_{other.committed_},
+    capacity_{other.capacity_}, step_{other.step_}
+#ifdef _WIN32
+    , views_{std::move(other.views_)}
+#endif
+  {
+    other.base_ = nullptr;
+  }
+
+
+  growable_mapping& operator = (growable_mapping&& other) noexcept {
+    close();
+    file_ = std::move(other.file_);
+    base_ = other.base_; other.base_ = nullptr;
+    size_ = other.size_;
+    committed_ = other.committed_;
+    capacity_ = other.capacity_;
+    step_ = other.step_;
+#ifdef _WIN32
+    views_ = std::move(other.views_);
+#endif
+    return *this;
+  }
+
+
+  explicit operator bool () const noexcept { return base_ != nullptr; }
+  char* data() const noexcept { return base_; }
+  size_type size() const noexcept { return size_; }
+  size_type committed() const noexcept { return committed_; }
+  size_type capacity() const noexcept { return capacity_; }
+
+
+  bool resize(size_type new_size) noexcept {
+    if(new_size < 0 || new_size > capacity_)
+      return false;
+    if(new_size > committed_ && !commit(round_up(new_size, step_)))
+      return false;
+    size_ = new_size;
+    return true;
+  }
+
+
+  char* append(size_type n) noexcept {
+    size_type const offset = size_;
+    if(!resize(size_ + n))
+      return nullptr;
+    return base_ + offset;
+  }
+
+
+  bool append(char const* data, size_type n) noexcept {
+    char* const target = append(n);
+    if(target == nullptr)
+      return false;
+    std::memcpy(target, data, size_t(n));
+    return true;
+  }
+
+
+  // Unmaps the reserved range and trims the file down to size()
+  void close() noexcept {
+    if(base_ == nullptr)
+      return;
+    release();
+    base_ = nullptr;
+    file_.resize(size_);
+    file_.close();
+    size_ = committed_ = capacity_ = 0;
+  }
+
+private:
+
+  file file_;
+  char* base_{nullptr};
+  size_type size_{0};
+  size_type committed_{0};
+  size_type capacity_{0};
+  size_type step_{default_step};
+
+
+  static size_type round_up(size_type n, size_type unit) noexcept {
+    return (n + unit - 1) / unit * unit;
+  }
+
+
+#ifdef _WIN32
+
+  std::vector<char*> views_;
+
+
+  bool reserve() noexcept {
+    base_ = static_cast<char*>(
+        VirtualAlloc2(nullptr, nullptr, SIZE_T(capacity_),
+                      MEM_RESERVE | MEM_RESERVE_PLACEHOLDER, PAGE_NOACCESS,
+                      nullptr, 0));
+    return base_ != nullptr;
+  }
+
+
+  bool commit(size_type new_committed) noexcept {
+    if(new_committed <= committed_)
+      return true;
+    if(!file_.resize(new_committed))
+      return false;
+    char* const address = base_ + committed_;
+    SIZE_T const chunk = SIZE_T(new_committed - committed_);
+    // split the placeholder so the view replaces exactly the new chunk
+    if(new_committed < capacity_ &&
+       !VirtualFree(address, chunk, MEM_RELEASE | MEM_PRESERVE_PLACEHOLDER))
+      return false;
+    HANDLE const mapping = CreateFileMappingW(file_.handle_, nullptr,
+                                              PAGE_READWRITE, 0, 0, nullptr);
+    if(mapping == nullptr)
+      return false;
+    void* const view = MapViewOfFile3(mapping, GetCurrentProcess(), address,
+                                      ULONG64(committed_), chunk,
+                                      MEM_REPLACE_PLACEHOLDER, PAGE_READWRITE,
+                                      nullptr, 0);
+    CloseHandle(mapping);
+    if(view == nullptr)
+      return false;
+    views_.push_back(address);
+    committed_ = new_committed;
+    return true;
+  }
+
+
+  void release() noexcept {
+    for(char* view: views_)
+      UnmapViewOfFile(view);
+    views_.clear();
+    if(committed_ < capacity_)
+      VirtualFree(base_ + committed_, 0, MEM_RELEASE);
+  }
+
+#else
+
+  bool reserve() noexcept {
+    void* const address = ::mmap(nullptr, size_t(capacity_), PROT_NONE,
+                                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                                 -1, 0);
+    if(address == MAP_FAILED)
+      return false;
+    base_ = static_cast<char*>(address);
+    return true;
+  }
+
+
+  bool commit(size_type new_committed) noexcept {
+    if(new_committed <= committed_)
+      return true;
+    if(!file_.resize(new_committed))
+      return false;
+    // MAP_FIXED replaces the reserved PROT_NONE pages in place
+    void* const address = ::mmap(base_ + committed_,
+                                 size_t(new_committed - committed_),
+                                 PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+                                 file_.handle_, off_t(committed_));
+    if(address == MAP_FAILED)
+      return false;
+    committed_ = new_committed;
+    return true;
+  }
+
+
+  void release() noexcept {
+    ::munmap(base_, size_t(capacity_));
+  }
+
+#endif // _WIN32
+
+}; // growable_mapping
+
+
+} // iofet
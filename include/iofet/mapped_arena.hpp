@@ -0,0 +1,273 @@
+/* This file is part of iofet library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+#include "mapped_file.hpp"
+
+
+namespace iofet {
+
+
+// Pointer stored as a distance from itself, so structures built of them
+// stay valid wherever the file is mapped next time
+template<typename T>
+class offset_ptr {
+public:
+  using element_type = T;
+
+  offset_ptr() noexcept = default;
+  offset_ptr(std::nullptr_t) noexcept { }
+  offset_ptr(T* p) noexcept { set(p); }
+  offset_ptr(offset_ptr const& other) noexcept { set(other.get()); }
+
+  offset_ptr& operator = (offset_ptr const& other) noexcept {
+    set(other.get());
+    return *this;
+  }
+
+  offset_ptr& operator = (T* p) noexcept {
+    set(p);
+    return *this;
+  }
+
+
+  T* get() const noexcept {
+    if(offset_ == null_offset)
+      return nullptr;
+    return reinterpret_cast<T*>(
+        reinterpret_cast<char*>(const_cast<offset_ptr*>(this)) + offset_);
+  }
+
+  T& operator * () const noexcept { return *get(); }
+  T* operator -> () const noexcept { return get(); }
+  T& operator [] (std::ptrdiff_t i) const noexcept { return get()[i]; }
+  explicit operator bool () const noexcept { return offset_ != null_offset; }
+
+  bool operator == (offset_ptr const& other) const noexcept { return get() == other.get(); }
+  bool operator != (offset_ptr const& other) const noexcept { return get() != other.get(); }
+
+private:
+  // an object never points into its own second byte
+  static constexpr std::ptrdiff_t null_offset = 1;
+
+  std::ptrdiff_t offset_{null_offset};
+
+  void set(T* p) noexcept {
+    if(p == nullptr) {
+      offset_ = null_offset;
+      return;
+    }
+    offset_ = reinterpret_cast<char*>(p) - reinterpret_cast<char*>(this);
+  }
+}; // offset_ptr
+
+
+// Allocator laid out inside a mapped region: blocks are carved from the top
+// of the arena and recycled through free lists of power of two size classes.
+// The header keeps a format version and a root object to find everything
+// else from after the region is mapped again. Not thread safe.
+class mapped_arena {
+public:
+  using size_type = mapped_file::size_type;
+
+  static constexpr std::uint32_t version = 1;
+  static constexpr size_type max_alignment = 64;
+  static constexpr std::uint64_t magic = 0x616e657261746566; // "fetarena"
+
+
+  static mapped_arena create(mapped_file::region& region) noexcept {
+    mapped_arena result;
+    if(!region || region.size < size_type(sizeof(header_type)))
+      return result;
+    auto* const header = new(region.address) header_type{};
+    header->magic = magic;
+    header->version = version;
+    header->size = std::uint64_t(region.size);
+    header->top = sizeof(header_type);
+    result.base_ = region.address;
+    return result;
+  }
+
+
+  static mapped_arena open(mapped_file::region& region) noexcept {
+    mapped_arena result;
+    if(!region || region.size < size_type(sizeof(header_type)))
+      return result;
+    auto const* const header = reinterpret_cast<header_type const*>(region.address);
+    if(header->magic != magic || header->version != version ||
+       header->size > std::uint64_t(region.size))
+      return result;
+    result.base_ = region.address;
+    return result;
+  }
+
+
+  mapped_arena() noexcept = default;
+
+  explicit operator bool () const noexcept { return base_ != nullptr; }
+  size_type capacity() const noexcept { return size_type(header()->size); }
+  size_type used() const noexcept { return size_type(header()->top); }
+
+
+  void* allocate(size_type size,
+                 size_type alignment = alignof(std::max_align_t)) noexcept {
+    if(size < 0 || alignment > max_alignment)
+      return nullptr;
+    std::size_t const index = size_class(size < alignment ? alignment : size);
+    if(index >= classes)
+      return nullptr;
+    header_type* const h = header();
+    std::uint64_t const block = min_block << index;
+    if(h->free[index] != 0) {
+      std::uint64_t const offset = h->free[index];
+      h->free[index] = *reinterpret_cast<std::uint64_t*>(base_ + offset);
+      return base_ + offset;
+    }
+    std::uint64_t const align = block < max_alignment ? block : max_alignment;
+    std::uint64_t const offset = (h->top + align - 1) / align * align;
+    if(offset + block > h->size || offset + block < offset)
+      return nullptr;
+    h->top = offset + block;
+    return base_ + offset;
+  }
+
+
+  void deallocate(void* p, size_type size,
+                  size_type alignment = alignof(std::max_align_t)) noexcept {
+    if(p == nullptr)
+      return;
+    std::size_t const index = size_class(size < alignment ? alignment : size);
+    header_type* const h = header();
+    std::uint64_t const offset = std::uint64_t(static_cast<char*>(p) - base_);
+    *static_cast<std::uint64_t*>(p) = h->free[index];
+    h->free[index] = offset;
+  }
+
+
+  template<typename T, typename... Args>
+  T* construct(Args&&... args) {
+    void* const p = allocate(sizeof(T), alignof(T));
+    if(p == nullptr)
+      return nullptr;
+    return new(p) T(std::forward<Args>(args)...);
+  }
+
+
+  template<typename T>
+  void destroy(T* p) noexcept {
+    if(p == nullptr)
+      return;
+    p->~T();
+    deallocate(p, sizeof(T), alignof(T));
+  }
+
+
+  template<typename T>
+  T* root() const noexcept {
+    std::uint64_t const offset = header()->root;
+    if(offset == 0)
+      return nullptr;
+    return reinterpret_cast<T*>(base_ + offset);
+  }
+
+
+  template<typename T>
+  void set_root(T* p) noexcept {
+    header()->root = p == nullptr
+      ? 0 : std::uint64_t(reinterpret_cast<char*>(p) - base_);
+  }
+
+private:
+
+  static constexpr std::size_t classes = 48;
+  static constexpr std::uint64_t min_block = 16;
+
+  struct header_type {
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t reserved;
+    std::uint64_t size;
+    std::uint64_t top;
+    std::uint64_t root;
+    std::uint64_t free[classes];
+  };
+
+  char* base_{nullptr};
+
+
+  header_type* header() const noexcept {
+    return reinterpret_cast<header_type*>(base_);
+  }
+
+
+  static std::size_t size_class(size_type size) noexcept {
+    std::size_t index = 0;
+    while(index < classes && (min_block << index) < std::uint64_t(size))
+      ++index;
+    return index;
+  }
+
+}; // mapped_arena
+
+
+// Lets std::pmr containers allocate from a mapped_arena. They keep plain
+// pointers inside, so they are only usable after a restart if the region
+// is mapped at the same address; offset_ptr based structures are not
+// bound to an address.
+class mapped_arena_resource: public std::pmr::memory_resource {
+public:
+  explicit mapped_arena_resource(mapped_arena& arena) noexcept:
+    arena_{&arena} { }
+
+private:
+  mapped_arena* arena_;
+
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+    void* const p = arena_->allocate(mapped_arena::size_type(bytes),
+                                     mapped_arena::size_type(alignment));
+    if(p == nullptr)
+      throw std::bad_alloc{};
+    return p;
+  }
+
+  void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+    arena_->deallocate(p, mapped_arena::size_type(bytes),
+                       mapped_arena::size_type(alignment));
+  }
+
+  bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override {
+    auto const* const resource = dynamic_cast<mapped_arena_resource const*>(&other);
+    return resource != nullptr && resource->arena_ == arena_;
+  }
+}; // mapped_arena_resource
+
+
+} // iofet
@@ -23,7 +23,12 @@
 #pragma once
 
 
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
 #include <system_error>
+#include <vector>
 
 #include "file.hpp"
 
@@ -43,12 +48,19 @@
 #endif
 
 #include <minwindef.h>
+#include <minwinbase.h>
 #include <memoryapi.h>
 #include <handleapi.h>
+#include <sysinfoapi.h>
+#include <processthreadsapi.h>
+#include <psapi.h>
 
 #else
-  
-#error Unsupported system
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #endif // WIN32
 
@@ -62,6 +74,9 @@ public:
   using offset_type = long long;
 
 
+  enum class flush_mode { sync, async };
+
+
   struct region {
     friend class mapped_file;
 
@@ -80,7 +95,8 @@ public:
     
     
     region(region&& other) noexcept:
-      address(other.address), size(other.size) {
+      address(other.address), size(other.size),
+      delta_(other.delta_), handle_(other.handle_) {
       other.address = nullptr;
     }
 
@@ -90,20 +106,106 @@ public:
         dispose();
       address = other.address; other.address = nullptr;
       size = other.size;
+      delta_ = other.delta_;
+      handle_ = other.handle_;
       return *this;
     }
 
 
+    bool flush(flush_mode mode = flush_mode::sync) noexcept {
+      return flush(0, size, mode);
+    }
+
+
+#ifdef _WIN32
+
+    // Pages of the view in the working set of the process
+    std::optional<size_type> resident_pages() const {
+      std::optional<size_type> result;
+      if(address == nullptr)
+        return result;
+      auto const page = std::uintptr_t(page_size());
+      auto const begin = reinterpret_cast<std::uintptr_t>(address) / page * page;
+      auto const end = reinterpret_cast<std::uintptr_t>(address + size);
+      std::vector<PSAPI_WORKING_SET_EX_INFORMATION> pages(
+          size_t((end - begin + page - 1) / page));
+      for(size_t i = 0; i != pages.size(); ++i)
+        pages[i].VirtualAddress = reinterpret_cast<void*>(begin + i * page);
+      if(!QueryWorkingSetEx(GetCurrentProcess(), pages.data(),
+            DWORD(pages.size() * sizeof(PSAPI_WORKING_SET_EX_INFORMATION))))
+        return result;
+      size_type resident = 0;
+      for(auto const& p: pages)
+        resident += p.VirtualAttributes.Valid;
+      return result = resident;
+    }
+
+
+    bool flush(offset_type offset, size_type n,
+               flush_mode mode = flush_mode::sync) noexcept {
+      if(address == nullptr || offset < 0 || n < 0 || offset + n > size)
+        return false;
+      if(!FlushViewOfFile(address + offset, SIZE_T(n)))
+        return false;
+      // views of the paging file have no file buffers to flush
+      if(mode == flush_mode::async || handle_ == INVALID_HANDLE_VALUE)
+        return true;
+      return !!FlushFileBuffers(handle_);
+    }
+
+#else
+
+    // Pages of the view held in memory
+    std::optional<size_type> resident_pages() const {
+      std::optional<size_type> result;
+      if(address == nullptr)
+        return result;
+      auto const page = std::uintptr_t(page_size());
+      auto const begin = reinterpret_cast<std::uintptr_t>(address) / page * page;
+      auto const end = reinterpret_cast<std::uintptr_t>(address + size);
+      std::vector<unsigned char> pages(size_t((end - begin + page - 1) / page));
+      if(::mincore(reinterpret_cast<void*>(begin), size_t(end - begin),
+                   pages.data()) == -1)
+        return result;
+      size_type resident = 0;
+      for(unsigned char p: pages)
+        resident += p & 1;
+      return result = resident;
+    }
+
+
+    bool flush(offset_type offset, size_type n,
+               flush_mode mode = flush_mode::sync) noexcept {
+      if(address == nullptr || offset < 0 || n < 0 || offset + n > size)
+        return false;
+      if(n == 0)
+        return true;
+      // msync wants a page aligned address
+      auto const begin = reinterpret_cast<std::uintptr_t>(address + offset);
+      auto const aligned = begin / page_size() * page_size();
+      int const flags = mode == flush_mode::sync ? MS_SYNC : MS_ASYNC;
+      return ::msync(reinterpret_cast<void*>(aligned),
+                     size_t(begin + n - aligned), flags) == 0;
+    }
+
+#endif // _WIN32
+
+
   private:
+
+    // distance from the granularity aligned start of the view to address
+    size_type delta_{0};
+    file::handle_type handle_{};
     
-    region(char* address, size_type size) noexcept:
-      address(address), size(size)
+    region(char* address, size_type size, size_type delta,
+           file::handle_type handle) noexcept:
+      address(address), size(size), delta_(delta), handle_(handle)
     { }
 
 #ifdef _WIN32
-    void dispose() noexcept { UnmapViewOfFile(address); }
+    void dispose() noexcept { UnmapViewOfFile(address - delta_); }
 #else
-    void dispose() noexcept { munmap(address, size); }
+    void dispose() noexcept { munmap(address - delta_, size + delta_); }
 #endif // _WIN32
   }; // region
 
@@ -112,6 +214,12 @@ public:
     return mapped_file{file::open_to_rw(std::move(path))};
   }
 
+
+  // Views of such a file can only be read
+  static mapped_file open_to_read(std::string path) noexcept {
+    return mapped_file{file::open_to_read(std::move(path)), true};
+  }
+
   
   static std::error_code last_error() noexcept {
     return file::last_error();
@@ -121,42 +229,207 @@ public:
   mapped_file() noexcept = default;
   mapped_file(mapped_file const&) noexcept = delete;
   mapped_file& operator = (mapped_file const&) noexcept = delete;
-  mapped_file(mapped_file&&) noexcept = default;
-  mapped_file& operator = (mapped_file&&) noexcept = default;
   
   
-  region map(offset_type offset, size_type size) noexcept {    
-    return region{mmap(offset, size), size};
+  // Any offset is accepted: the enclosing granularity aligned window is
+  // mapped and the region points at the requested byte
+  region map(offset_type offset, size_type size) noexcept {
+    offset_type const aligned = offset / granularity() * granularity();
+    size_type const delta = offset - aligned;
+    char* const base = mmap(aligned, size + delta);
+    if(base == nullptr)
+      return region{};
+    return region{base + delta, size, delta, file_.handle_};
   }
   
   
   region map() noexcept {
     region result;
-    auto const size = file_.size();
+    auto const size = this->size();
     if (!size)
       return std::move(result);
-    return std::move(result = region{ mmap(0, *size), *size });
+    return std::move(result = region{ mmap(0, *size), *size, 0, file_.handle_ });
+  }
+
+
+  bool read_only() const noexcept {
+    return read_only_;
   }
 
 
 #ifdef _WIN32
 
+  using native_handle_type = HANDLE;
+
+
+  // Named memory backed by the paging file
+  static mapped_file open_shared_memory(std::string const& name,
+                                        size_type size) noexcept {
+    std::filesystem::path const wide{name};
+    return mapped_file{create_mapping(nullptr, size, wide.c_str()), size};
+  }
+
+
+  // Unnamed memory backed by the paging file, its handle is inheritable
+  static mapped_file anonymous(size_type size) noexcept {
+    SECURITY_ATTRIBUTES attributes{sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE};
+    return mapped_file{create_mapping(&attributes, size, nullptr), size};
+  }
+
+
+  // Adopts a mapping handle inherited from the parent process
+  static mapped_file inherit(native_handle_type handle, size_type size) noexcept {
+    return mapped_file{handle, size};
+  }
+
+
+  // Named mappings disappear with their last handle
+  static bool remove_shared_memory(std::string const&) noexcept {
+    return true;
+  }
+
+
+  ~mapped_file() noexcept {
+    if(mapping_ != INVALID_HANDLE_VALUE)
+      CloseHandle(mapping_);
+  }
+
+
+  mapped_file(mapped_file&& other) noexcept:
+    file_{std::move(other.file_)}, read_only_{other.read_only_},
+    mapping_{other.mapping_}, size_{other.size_} {
+    other.mapping_ = INVALID_HANDLE_VALUE;
+  }
+
+
+  mapped_file& operator = (mapped_file&& other) noexcept {
+    if(mapping_ != INVALID_HANDLE_VALUE)
+      CloseHandle(mapping_);
+    file_ = std::move(other.file_);
+    read_only_ = other.read_only_;
+    mapping_ = other.mapping_; other.mapping_ = INVALID_HANDLE_VALUE;
+    size_ = other.size_;
+    return *this;
+  }
+
+
+  std::optional<size_type> size() const noexcept {
+    if(!file_)
+      return size_;
+    return file_.size();
+  }
+
+
+  // Views have to be unmapped before the file shrinks
+  bool resize(size_type new_size) noexcept {
+    if(!file_)
+      return false;
+    if(mapping_ != INVALID_HANDLE_VALUE)
+      CloseHandle(mapping_);
+    bool const resized = file_.resize(new_size);
+    mapping_ = create_mapping();
+    return resized && mapping_ != INVALID_HANDLE_VALUE;
+  }
+
+
+  native_handle_type native_handle() const noexcept {
+    return mapping_;
+  }
+
+
   explicit operator bool() const noexcept {
     return mapping_ != INVALID_HANDLE_VALUE;
   }
 
-  static size_type granularity() {
-    return 65536;
+  static size_type granularity() noexcept {
+    static size_type const cached = [] {
+      SYSTEM_INFO info;
+      GetSystemInfo(&info);
+      return size_type(info.dwAllocationGranularity);
+    }();
+    return cached;
+  }
+
+  static size_type page_size() noexcept {
+    static size_type const cached = [] {
+      SYSTEM_INFO info;
+      GetSystemInfo(&info);
+      return size_type(info.dwPageSize);
+    }();
+    return cached;
   }
   
 #else
+
+  using native_handle_type = int;
+
+
+  // Named POSIX shared memory, it lives on until remove_shared_memory
+  static mapped_file open_shared_memory(std::string const& name,
+                                        size_type size) noexcept {
+    std::string const path = name.size() > 0 && name[0] == '/' ? name : '/' + name;
+    file f{::shm_open(path.data(), O_CREAT | O_RDWR, S_IRUSR | S_IWUSR)};
+    if(!f)
+      return mapped_file{};
+    auto const current = f.size();
+    if(!current || (*current < size && !f.resize(size)))
+      return mapped_file{};
+    return mapped_file{std::move(f)};
+  }
+
+
+  // Unnamed memory file, its descriptor is inherited by child processes
+  static mapped_file anonymous(size_type size) noexcept {
+    file f{::memfd_create("iofet", 0)};
+    if(!f || !f.resize(size))
+      return mapped_file{};
+    return mapped_file{std::move(f)};
+  }
+
+
+  // Adopts a descriptor inherited from the parent process
+  static mapped_file inherit(native_handle_type handle, size_type) noexcept {
+    return mapped_file{file{handle}};
+  }
+
+
+  static bool remove_shared_memory(std::string const& name) noexcept {
+    std::string const path = name.size() > 0 && name[0] == '/' ? name : '/' + name;
+    return ::shm_unlink(path.data()) == 0;
+  }
+
+
+  mapped_file(mapped_file&&) noexcept = default;
+  mapped_file& operator = (mapped_file&&) noexcept = default;
+
+
+  std::optional<size_type> size() const noexcept {
+    return file_.size();
+  }
+
+
+  // Views have to be unmapped before the file shrinks
+  bool resize(size_type new_size) noexcept {
+    return file_.resize(new_size);
+  }
+
+
+  native_handle_type native_handle() const noexcept {
+    return file_.handle_;
+  }
+
   
   explicit operator bool() const noexcept {
     return !!file_;
   }
 
-  static size_type granularity() {
-    return 65536;
+  static size_type granularity() noexcept {
+    return page_size();
+  }
+
+  static size_type page_size() noexcept {
+    static size_type const cached = size_type(sysconf(_SC_PAGESIZE));
+    return cached;
   }
 
 #endif // _WIN32
@@ -164,38 +437,61 @@ public:
 private:
 
   file file_;
+  bool read_only_{false};
   
 #ifdef _WIN32
   
   HANDLE mapping_{INVALID_HANDLE_VALUE};
+  size_type size_{0}; // of mappings without a file
+
+  explicit mapped_file(file&& f, bool read_only = false) noexcept:
+    file_{std::move(f)}, read_only_{read_only} {
+    mapping_ = create_mapping();
+  }
+
+
+  HANDLE create_mapping() const noexcept {
+    HANDLE const mapping = CreateFileMappingW(
+        file_.handle_, nullptr, read_only_ ? PAGE_READONLY : PAGE_READWRITE,
+        0, 0, nullptr);
+    return mapping == nullptr ? INVALID_HANDLE_VALUE : mapping;
+  }
+
+
+  mapped_file(HANDLE mapping, size_type size) noexcept:
+    mapping_{mapping == nullptr ? INVALID_HANDLE_VALUE : mapping}, size_{size} {
+  }
+
 
-  explicit mapped_file(file&& f) noexcept:
-    file_{std::move(f)} {
-    mapping_ = CreateFileMappingW(file_.handle_, nullptr, PAGE_READWRITE,
-                                  0, 0, nullptr);
+  static HANDLE create_mapping(SECURITY_ATTRIBUTES* attributes, size_type size,
+                               wchar_t const* name) noexcept {
+    return CreateFileMappingW(INVALID_HANDLE_VALUE, attributes, PAGE_READWRITE,
+                              DWORD(size >> 32), DWORD(size), name);
   }
   
   
   char* mmap(offset_type offset, size_type size) noexcept {
     return reinterpret_cast<char*>(
-            MapViewOfFile(mapping_, FILE_MAP_READ | FILE_MAP_WRITE,
+            MapViewOfFile(mapping_,
+                          read_only_ ? FILE_MAP_READ : FILE_MAP_READ | FILE_MAP_WRITE,
                           DWORD(offset >> 32), DWORD(offset), size));
   }
 
     
 #else
 
-  explicit mapped_file(cellarium::file&& f) noexcept:
-    file_{std::move(f)} {
+  explicit mapped_file(file&& f, bool read_only = false) noexcept:
+    file_{std::move(f)}, read_only_{read_only} {
   }
   
   
   char* mmap(offset_type offset, size_type size) noexcept {
-    char* address = mmap(nullptr, size, PROT_READ|PROT_WRITE,
-                         MAP_PRIVATE|MAP_NORESERVE, file_.handle_, offset);
+    int const protection = read_only_ ? PROT_READ : PROT_READ|PROT_WRITE;
+    void* address = ::mmap(nullptr, size_t(size), protection,
+                           MAP_SHARED, file_.handle_, off_t(offset));
     if(address == MAP_FAILED)
       return nullptr;
-    return address;
+    return static_cast<char*>(address);
   }
 
  
@@ -204,4 +500,4 @@ private:
 }; // mapped_file
   
   
-} // cellarium
+} // iofet
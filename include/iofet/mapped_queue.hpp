@@ -0,0 +1,368 @@
+/* This file is part of iofet library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+
+#include "file.hpp"
+#include "mapped_file.hpp"
+
+
+#ifdef _WIN32
+
+#if !defined(_X86_) && !defined(_AMD64_) && !defined(_ARM_) && !defined(_ARM64_)
+#if defined(_M_IX86)
+#define _X86_
+#elif defined(_M_AMD64)
+#define _AMD64_
+#elif defined(_M_ARM)
+#define _ARM_
+#elif defined(_M_ARM64)
+#define _ARM64_
+#endif
+#endif
+
+#include <minwindef.h>
+#include <synchapi.h>
+
+#else
+
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#endif // WIN32
+
+
+namespace iofet {
+
+
+// Bounded multiple producer, single consumer message queue living in a file
+// and shared by every process that opens it. Messages are up to
+// message_size() bytes, one per slot; slots are claimed with a per slot
+// sequence number, so producers never take a lock. The consumer position
+// is stored in the file, so a restarted consumer resumes where it stopped.
+class mapped_queue {
+public:
+  using size_type = mapped_file::size_type;
+
+  static constexpr size_type cache_line = 64;
+  static constexpr std::uint64_t magic = 0x6575657571746566; // "fetqueue"
+
+
+  static mapped_queue create(std::filesystem::path const& path,
+                             size_type message_size,
+                             size_type slot_count) noexcept {
+    mapped_queue result;
+    if(message_size <= 0 || slot_count <= 0)
+      return result;
+    size_type const stride = round_up(sizeof(slot_type) + message_size, cache_line);
+    {
+      auto f = file::create(path);
+      if(!f || !f.resize(header_size() + stride * slot_count))
+        return result;
+    }
+    if(!result.map(path))
+      return result;
+    header_type* const header = result.header();
+    header->magic = magic;
+    header->message_size = std::uint64_t(message_size);
+    header->slot_count = std::uint64_t(slot_count);
+    header->stride = std::uint64_t(stride);
+    header->tail.store(0, std::memory_order_relaxed);
+    header->head.store(0, std::memory_order_relaxed);
+    header->signal.store(0, std::memory_order_relaxed);
+    header->waiters.store(0, std::memory_order_relaxed);
+    result.stride_ = stride;
+    result.slot_count_ = slot_count;
+    for(size_type i = 0; i != slot_count; ++i)
+      result.slot(std::uint64_t(i))->sequence.store(std::uint64_t(i),
+                                                    std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return result;
+  }
+
+
+  static mapped_queue open(std::filesystem::path const& path) noexcept {
+    mapped_queue result;
+    if(!result.map(path))
+      return result;
+    header_type const* const header = result.header();
+    if(result.region_.size < header_size() || header->magic != magic ||
+       header_size() + header->stride * header->slot_count
+         != std::uint64_t(result.region_.size)) {
+      result.region_ = mapped_file::region{};
+      return result;
+    }
+    result.stride_ = size_type(header->stride);
+    result.slot_count_ = size_type(header->slot_count);
+    result.repair();
+    return result;
+  }
+
+
+  static std::error_code last_error() noexcept {
+    return mapped_file::last_error();
+  }
+
+
+  mapped_queue() noexcept = default;
+  mapped_queue(mapped_queue const&) = delete;
+  mapped_queue& operator = (mapped_queue const&) = delete;
+  mapped_queue(mapped_queue&&) noexcept = default;
+  mapped_queue& operator = (mapped_queue&&) noexcept = default;
+
+
+  explicit operator bool () const noexcept { return !!region_; }
+  size_type message_size() const noexcept {
+    return region_ ? size_type(header()->message_size) : 0;
+  }
+  size_type slot_count() const noexcept { return slot_count_; }
+
+
+  size_type size() const noexcept {
+    if(!region_)
+      return 0;
+    auto const head = header()->head.load(std::memory_order_acquire);
+    auto const tail = header()->tail.load(std::memory_order_acquire);
+    return tail > head ? size_type(tail - head) : 0;
+  }
+
+
+  // Producer side, safe to call from any number of threads and processes
+
+  bool try_push(char const* data, size_type n) noexcept {
+    if(!region_ || n < 0 || n > message_size())
+      return false;
+    header_type* const h = header();
+    auto position = h->tail.load(std::memory_order_relaxed);
+    for(;;) {
+      slot_type* const s = slot(position);
+      auto const sequence = s->sequence.load(std::memory_order_acquire);
+      auto const difference = std::int64_t(sequence - position);
+      if(difference == 0) {
+        if(h->tail.compare_exchange_weak(position, position + 1,
+                                         std::memory_order_relaxed))
+          break;
+      } else if(difference < 0) {
+        return false; // full
+      } else {
+        position = h->tail.load(std::memory_order_relaxed);
+      }
+    }
+    slot_type* const s = slot(position);
+    s->size = std::uint64_t(n);
+    std::memcpy(payload(s), data, size_t(n));
+    s->sequence.store(position + 1, std::memory_order_release);
+    h->signal.fetch_add(1, std::memory_order_release);
+    if(h->waiters.load(std::memory_order_seq_cst) != 0)
+      wake(h->signal);
+    return true;
+  }
+
+
+  // Consumer side, one consumer at a time
+
+  // Calls f(char const* data, size_type size) on the oldest message in place
+  template<typename F>
+  bool try_consume(F&& f) {
+    if(!region_)
+      return false;
+    header_type* const h = header();
+    auto const position = h->head.load(std::memory_order_relaxed);
+    slot_type* const s = slot(position);
+    if(s->sequence.load(std::memory_order_acquire) != position + 1)
+      return false;
+    f(static_cast<char const*>(payload(s)), size_type(s->size));
+    s->sequence.store(position + std::uint64_t(slot_count_),
+                      std::memory_order_release);
+    h->head.store(position + 1, std::memory_order_release);
+    return true;
+  }
+
+
+  // buffer should have room for message_size() bytes
+  std::optional<size_type> try_pop(char* buffer) noexcept {
+    std::optional<size_type> result;
+    try_consume([&](char const* data, size_type n) noexcept {
+      std::memcpy(buffer, data, size_t(n));
+      result = n;
+    });
+    return result;
+  }
+
+
+  std::optional<size_type> pop(char* buffer,
+                               std::chrono::milliseconds timeout) noexcept {
+    if(!region_)
+      return std::nullopt;
+    auto const deadline = std::chrono::steady_clock::now() + timeout;
+    header_type* const h = header();
+    for(;;) {
+      auto result = try_pop(buffer);
+      if(result)
+        return result;
+      auto const signal = h->signal.load(std::memory_order_acquire);
+      h->waiters.fetch_add(1, std::memory_order_seq_cst);
+      result = try_pop(buffer);
+      if(!result) {
+        auto const now = std::chrono::steady_clock::now();
+        if(now < deadline)
+          wait(h->signal, signal,
+               std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now));
+      }
+      h->waiters.fetch_sub(1, std::memory_order_relaxed);
+      if(result)
+        return result;
+      if(std::chrono::steady_clock::now() >= deadline)
+        return try_pop(buffer);
+    }
+  }
+
+private:
+
+  struct header_type {
+    std::uint64_t magic;
+    std::uint64_t message_size;
+    std::uint64_t slot_count;
+    std::uint64_t stride;
+    alignas(cache_line) std::atomic<std::uint64_t> tail;
+    alignas(cache_line) std::atomic<std::uint64_t> head;
+    alignas(cache_line) std::atomic<std::uint32_t> signal;
+    std::atomic<std::uint32_t> waiters;
+  };
+
+  struct slot_type {
+    std::atomic<std::uint64_t> sequence;
+    std::uint64_t size;
+  };
+
+  // counters are shared with other processes through the file
+  static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+  static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t));
+
+  mapped_file file_;
+  mapped_file::region region_;
+  size_type stride_{0};
+  size_type slot_count_{0};
+
+
+  // A consumer stopped between releasing its slot and storing the new head
+  // leaves head on a slot already handed back to producers: its sequence is
+  // a lap ahead (head + slot_count, or one more once refilled) instead of
+  // head or head + 1, and the consumer would wait on it forever. Producers
+  // open the queue too while a consumer runs, so head is only moved if no
+  // consumer moved it meanwhile.
+  void repair() noexcept {
+    header_type* const h = header();
+    auto head = h->head.load(std::memory_order_acquire);
+    auto const sequence = slot(head)->sequence.load(std::memory_order_acquire);
+    if(sequence - head >= std::uint64_t(slot_count_))
+      h->head.compare_exchange_strong(head, head + 1, std::memory_order_acq_rel,
+                                      std::memory_order_relaxed);
+  }
+
+
+  static size_type round_up(size_type n, size_type unit) noexcept {
+    return (n + unit - 1) / unit * unit;
+  }
+
+
+  static size_type header_size() noexcept {
+    return round_up(sizeof(header_type), cache_line);
+  }
+
+
+  bool map(std::filesystem::path const& path) noexcept {
+    file_ = mapped_file::open(path.string());
+    if(!file_)
+      return false;
+    region_ = file_.map();
+    return !!region_;
+  }
+
+
+  header_type* header() const noexcept {
+    return reinterpret_cast<header_type*>(region_.address);
+  }
+
+
+  slot_type* slot(std::uint64_t position) const noexcept {
+    auto const index = size_type(position % std::uint64_t(slot_count_));
+    return reinterpret_cast<slot_type*>(region_.address + header_size()
+                                        + index * stride_);
+  }
+
+
+  static void* payload(slot_type* s) noexcept {
+    return s + 1;
+  }
+
+
+#ifdef _WIN32
+
+  // WaitOnAddress does not cross process boundaries: poll instead
+  static void wait(std::atomic<std::uint32_t>& signal, std::uint32_t expected,
+                   std::chrono::milliseconds timeout) noexcept {
+    auto const deadline = std::chrono::steady_clock::now() + timeout;
+    while(signal.load(std::memory_order_acquire) == expected &&
+          std::chrono::steady_clock::now() < deadline)
+      Sleep(1);
+  }
+
+
+  static void wake(std::atomic<std::uint32_t>&) noexcept { }
+
+#else
+
+  static void wait(std::atomic<std::uint32_t>& signal, std::uint32_t expected,
+                   std::chrono::milliseconds timeout) noexcept {
+    timespec relative;
+    relative.tv_sec = time_t(timeout.count() / 1000);
+    relative.tv_nsec = long(timeout.count() % 1000 * 1000000);
+    // shared futex: the word may be mapped by several processes
+    ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&signal), FUTEX_WAIT,
+              expected, &relative, nullptr, 0);
+  }
+
+
+  static void wake(std::atomic<std::uint32_t>& signal) noexcept {
+    ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&signal), FUTEX_WAKE,
+              INT_MAX, nullptr, nullptr, 0);
+  }
+
+#endif // _WIN32
+
+}; // mapped_queue
+
+
+} // iofet
@@ -0,0 +1,214 @@
+/* This file is part of iofet library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+
+#include <cstring>
+#include <filesystem>
+#include <type_traits>
+
+#include "mapped_file.hpp"
+
+
+namespace iofet {
+
+
+// Array of trivially copyable records stored in a file and accessed through
+// a mapping. The file grows geometrically and is remapped, so pointers into
+// the vector are invalidated by growth like with std::vector. On close the
+// file is trimmed to exactly size() records.
+template<typename T>
+class mapped_vector {
+public:
+  static_assert(std::is_trivially_copyable_v<T>,
+                "mapped_vector elements are copied as raw bytes");
+
+  using value_type = T;
+  using size_type = mapped_file::size_type;
+  using iterator = T*;
+  using const_iterator = T const*;
+
+
+  static mapped_vector open(std::filesystem::path const& path) noexcept {
+    mapped_vector result;
+    result.file_ = mapped_file::open(path.string());
+    if(!result.file_)
+      return result;
+    auto const bytes = result.file_.size();
+    if(!bytes || *bytes % size_type(sizeof(T)) != 0) {
+      result.file_ = mapped_file{};
+      return result;
+    }
+    result.size_ = result.capacity_ = *bytes / size_type(sizeof(T));
+    if(result.capacity_ != 0 && !result.remap())
+      result.file_ = mapped_file{};
+    return result;
+  }
+
+
+  static std::error_code last_error() noexcept {
+    return mapped_file::last_error();
+  }
+
+
+  mapped_vector() noexcept = default;
+  ~mapped_vector() noexcept { close(); }
+  mapped_vector(mapped_vector const&) = delete;
+  mapped_vector& operator = (mapped_vector const&) = delete;
+
+  mapped_vector(mapped_vector&& other) noexcept:
+    file_{std::move(other.file_)}, region_{std::move(other.region_)},
+    size_{other.size_}, capacity_{other.capacity_} {
+    other.size_ = other.capacity_ = 0;
+  }
+
+  mapped_vector& operator = (mapped_vector&& other) noexcept {
+    close();
+    file_ = std::move(other.file_);
+    region_ = std::move(other.region_);
+    size_ = other.size_; other.size_ = 0;
+    capacity_ = other.capacity_; other.capacity_ = 0;
+    return *this;
+  }
+
+
+  explicit operator bool () const noexcept { return !!file_; }
+  bool empty() const noexcept { return size_ == 0; }
+  size_type size() const noexcept { return size_; }
+  size_type capacity() const noexcept { return capacity_; }
+
+  T* data() noexcept { return reinterpret_cast<T*>(region_.address); }
+  T const* data() const noexcept { return reinterpret_cast<T const*>(region_.address); }
+  iterator begin() noexcept { return data(); }
+  iterator end() noexcept { return data() + size_; }
+  const_iterator begin() const noexcept { return data(); }
+  const_iterator end() const noexcept { return data() + size_; }
+  T& operator [] (size_type i) noexcept { return data()[i]; }
+  T const& operator [] (size_type i) const noexcept { return data()[i]; }
+  T& front() noexcept { return data()[0]; }
+  T& back() noexcept { return data()[size_ - 1]; }
+
+
+  bool reserve(size_type n) noexcept {
+    if(n <= capacity_)
+      return true;
+    if(!file_)
+      return false;
+#ifdef _WIN32
+    // A file with a mapped view can't be resized
+    region_ = mapped_file::region{};
+#endif
+    if(!file_.resize(n * size_type(sizeof(T))))
+      return restore();
+    auto grown = file_.map();
+    if(!grown)
+      return restore();
+    region_ = std::move(grown);
+    capacity_ = n;
+    return true;
+  }
+
+
+  bool push_back(T const& value) noexcept {
+    if(size_ == capacity_ && !reserve(grown(size_ + 1)))
+      return false;
+    std::memcpy(data() + size_, &value, sizeof(T));
+    ++size_;
+    return true;
+  }
+
+
+  // Bulk copy, the file grows at most once
+  bool append(T const* values, size_type n) noexcept {
+    if(size_ + n > capacity_ && !reserve(grown(size_ + n)))
+      return false;
+    std::memcpy(data() + size_, values, size_t(n) * sizeof(T));
+    size_ += n;
+    return true;
+  }
+
+
+  bool resize(size_type n, T const& value = T{}) noexcept {
+    if(n > capacity_ && !reserve(grown(n)))
+      return false;
+    for(size_type i = size_; i < n; ++i)
+      std::memcpy(data() + i, &value, sizeof(T));
+    size_ = n;
+    return true;
+  }
+
+
+  void pop_back() noexcept { --size_; }
+  void clear() noexcept { size_ = 0; }
+
+
+  // Unmaps the file and trims it to size() records
+  void close() noexcept {
+    if(!file_)
+      return;
+    region_ = mapped_file::region{};
+    file_.resize(size_ * size_type(sizeof(T)));
+    file_ = mapped_file{};
+    size_ = capacity_ = 0;
+  }
+
+private:
+
+  mapped_file file_;
+  mapped_file::region region_;
+  size_type size_{0};
+  size_type capacity_{0};
+
+
+  size_type grown(size_type needed) const noexcept {
+    size_type const minimal = (mapped_file::granularity() + size_type(sizeof(T)) - 1)
+                              / size_type(sizeof(T));
+    size_type result = capacity_ < minimal ? minimal : 2 * capacity_;
+    return result < needed ? needed : result;
+  }
+
+
+  bool remap() noexcept {
+    region_ = file_.map();
+    return !!region_;
+  }
+
+
+  // Keeps the old records reachable after a failed growth. If even the old
+  // extent can't be mapped the file is detached untrimmed, so the records
+  // survive on disk. Always fails.
+  bool restore() noexcept {
+    if(!region_ && capacity_ != 0)
+      region_ = file_.map(0, capacity_ * size_type(sizeof(T)));
+    if(!region_ && capacity_ != 0) {
+      file_ = mapped_file{};
+      size_ = capacity_ = 0;
+    }
+    return false;
+  }
+
+}; // mapped_vector
+
+
+} // iofet
@@ -0,0 +1,283 @@
+/* This file is part of iofet library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "directory_reader.hpp"
+#include "glob.hpp"
+
+
+namespace iofet {
+
+
+// Predicates on entry metadata; unset ones are not checked and cost nothing
+struct metadata_filter {
+  using time_point = std::chrono::system_clock::time_point;
+
+  std::optional<directory_reader::entry_type> type;
+  std::optional<std::uint64_t> min_size;
+  std::optional<std::uint64_t> max_size;
+  std::optional<time_point> modified_after;
+  std::optional<time_point> modified_before;
+
+  bool needs_size() const noexcept { return min_size || max_size; }
+  bool needs_time() const noexcept { return modified_after || modified_before; }
+};
+
+
+struct metadata_entry {
+  std::filesystem::path::string_type name;
+  directory_reader::entry_type type{directory_reader::entry_type::unknown};
+  std::uint64_t inode{0};
+  // set only when the filter has size or time predicates
+  std::uint64_t size{0};
+  metadata_filter::time_point modified;
+};
+
+
+namespace detail {
+
+#ifdef _WIN32
+  // FILETIME counts 100 ns ticks since 1601
+  inline std::chrono::system_clock::time_point from_filetime(FILETIME const& time) noexcept {
+    std::uint64_t const ticks = std::uint64_t(time.dwHighDateTime) << 32 | time.dwLowDateTime;
+    std::uint64_t const unix_epoch = 116444736000000000ull;
+    return std::chrono::system_clock::time_point{std::chrono::duration_cast<
+        std::chrono::system_clock::duration>(
+            std::chrono::duration<std::int64_t, std::ratio<1, 10000000>>{
+                std::int64_t(ticks - unix_epoch)})};
+  }
+#else
+  inline std::chrono::system_clock::time_point from_timespec(std::int64_t seconds,
+                                                             std::int64_t nanoseconds) noexcept {
+    return std::chrono::system_clock::time_point{std::chrono::duration_cast<
+        std::chrono::system_clock::duration>(
+            std::chrono::seconds{seconds} + std::chrono::nanoseconds{nanoseconds})};
+  }
+#endif // _WIN32
+
+
+  // Fetches the size and the modification time of result as asked, and its
+  // type when the listing did not tell; false when it can not
+  inline bool fetch_metadata([[maybe_unused]] directory_reader const& reader,
+                             [[maybe_unused]] std::filesystem::path const& directory,
+                             metadata_entry& result,
+                             [[maybe_unused]] bool size, [[maybe_unused]] bool time) noexcept {
+    [[maybe_unused]] bool const type = result.type == directory_reader::entry_type::unknown;
+#ifdef _WIN32
+    // the listing already reported the type
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if(!GetFileAttributesExW((directory / result.name).c_str(), GetFileExInfoStandard, &data))
+      return false;
+    result.size = std::uint64_t(data.nFileSizeHigh) << 32 | data.nFileSizeLow;
+    result.modified = from_filetime(data.ftLastWriteTime);
+    return true;
+#else
+    mode_t mode = 0;
+#ifdef STATX_SIZE
+    // only the fields asked for, and no round trip to a network server
+    unsigned const mask = (size ? STATX_SIZE : 0u) | (time ? STATX_MTIME : 0u) |
+                          (type ? STATX_TYPE : 0u);
+    struct statx stx;
+    if(::statx(reader.native_handle(), result.name.c_str(),
+               AT_SYMLINK_NOFOLLOW | AT_STATX_DONT_SYNC, mask, &stx) == 0) {
+      if((stx.stx_mask & mask) != mask)
+        return false;
+      result.size = stx.stx_size;
+      result.modified = from_timespec(stx.stx_mtime.tv_sec, stx.stx_mtime.tv_nsec);
+      mode = stx.stx_mode;
+    } else if(errno != ENOSYS)
+      return false;
+    else
+#endif // STATX_SIZE
+    {
+      struct stat st;
+      if(::fstatat(reader.native_handle(), result.name.c_str(), &st, AT_SYMLINK_NOFOLLOW) == -1)
+        return false;
+      result.size = std::uint64_t(st.st_size);
+      result.modified = from_timespec(st.st_mtim.tv_sec, st.st_mtim.tv_nsec);
+      mode = st.st_mode;
+    }
+    if(type)
+      switch(mode & S_IFMT) {
+        case S_IFREG: result.type = directory_reader::entry_type::regular; break;
+        case S_IFDIR: result.type = directory_reader::entry_type::directory; break;
+        case S_IFLNK: result.type = directory_reader::entry_type::symlink; break;
+        case S_IFBLK: result.type = directory_reader::entry_type::block; break;
+        case S_IFCHR: result.type = directory_reader::entry_type::character; break;
+        case S_IFIFO: result.type = directory_reader::entry_type::fifo; break;
+        case S_IFSOCK: result.type = directory_reader::entry_type::socket; break;
+        default: break;
+      }
+    return true;
+#endif // _WIN32
+  }
+
+
+  inline bool accepted(metadata_filter const& filter, metadata_entry const& e) noexcept {
+    if(filter.type && e.type != *filter.type)
+      return false;
+    if(filter.min_size && e.size < *filter.min_size)
+      return false;
+    if(filter.max_size && e.size > *filter.max_size)
+      return false;
+    if(filter.modified_after && !(e.modified > *filter.modified_after))
+      return false;
+    if(filter.modified_before && !(e.modified < *filter.modified_before))
+      return false;
+    return true;
+  }
+
+} // detail
+
+
+
+// Entries of a directory matching a mask and a metadata_filter. The whole
+// directory is listed first with directory_reader; names failing the mask,
+// or the type predicate when the listing tells the type, never cost a
+// system call. The rest are stat'ed relative to the directory descriptor in
+// inode order, which keeps the inode table reads sequential, asking statx
+// for only the fields the filter uses. Entries come in inode order.
+class metadata_mask_iterator {
+public:
+
+  using value_type = metadata_entry;
+  using pointer = metadata_entry const*;
+  using reference = metadata_entry const&;
+  using iterator_category = std::input_iterator_tag;
+
+  metadata_mask_iterator() noexcept = default;
+
+
+  metadata_mask_iterator(std::filesystem::path const& path,
+                         std::string const& mask,
+                         metadata_filter const& filter,
+                         std::error_code& ec):
+    metadata_mask_iterator{path, glob{std::filesystem::path{mask}.native()}, filter, ec}
+  { }
+
+
+  metadata_mask_iterator(std::filesystem::path const& path,
+                         glob const& mask,
+                         metadata_filter const& filter,
+                         std::error_code& ec) {
+    auto reader = directory_reader::open(path);
+    if(!reader) {
+      ec = directory_reader::last_error();
+      return;
+    }
+    auto candidates = std::make_shared<std::vector<metadata_entry>>();
+    directory_reader::entry e;
+    while(reader.next(e)) {
+      if(!mask.matches(e.name))
+        continue;
+      if(filter.type && e.type != directory_reader::entry_type::unknown && e.type != *filter.type)
+        continue;
+      candidates->push_back(metadata_entry{std::filesystem::path::string_type{e.name},
+                                           e.type, e.inode, 0, {}});
+    }
+    if(!!(ec = directory_reader::last_error()))
+      return;
+
+    bool const unknown_types = filter.type &&
+        std::any_of(candidates->begin(), candidates->end(), [](metadata_entry const& c) {
+          return c.type == directory_reader::entry_type::unknown;
+        });
+    std::sort(candidates->begin(), candidates->end(),
+              [](metadata_entry const& a, metadata_entry const& b) { return a.inode < b.inode; });
+    bool const stat_all = filter.needs_size() || filter.needs_time();
+    if(stat_all || unknown_types) {
+      // entries removed in between are skipped; without size or time
+      // predicates an entry of known type already passed the filter
+      auto const last = std::remove_if(candidates->begin(), candidates->end(),
+          [&](metadata_entry& c) {
+            if(!stat_all && c.type != directory_reader::entry_type::unknown)
+              return false;
+            return !detail::fetch_metadata(reader, path, c, filter.needs_size(), filter.needs_time()) || !detail::accepted(filter, c);
+          });
+      candidates->erase(last, candidates->end());
+    }
+    if(candidates->empty())
+      return;
+    entries_ = std::move(candidates);
+  }
+
+
+  bool operator == (metadata_mask_iterator const& other) const noexcept {
+    return entries_ == other.entries_ && (!entries_ || index_ == other.index_);
+  }
+
+
+  bool operator != (metadata_mask_iterator const& other) const noexcept {
+    return !(*this == other);
+  }
+
+
+  metadata_mask_iterator& operator ++ () {
+    if(++index_ == entries_->size()) {
+      entries_.reset();
+      index_ = 0;
+    }
+    return *this;
+  }
+
+
+  metadata_entry const& operator * () const {
+    return (*entries_)[index_];
+  }
+
+
+  metadata_entry const* operator -> () const {
+    return &(*entries_)[index_];
+  }
+
+private:
+  std::shared_ptr<std::vector<metadata_entry>> entries_;
+  std::size_t index_{0};
+};
+
+
+inline metadata_mask_iterator begin(metadata_mask_iterator const& iter) noexcept {
+  return iter;
+}
+
+
+inline metadata_mask_iterator end(metadata_mask_iterator const&) noexcept {
+  return metadata_mask_iterator{};
+}
+
+
+} // iofet
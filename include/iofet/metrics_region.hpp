@@ -0,0 +1,286 @@
+/* This file is part of iofet library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <new>
+#include <string_view>
+
+#include "file.hpp"
+#include "mapped_file.hpp"
+
+
+namespace iofet {
+
+
+// Counters and histograms kept in a file that a monitoring tool maps read
+// only while the service updates them. A header describes every metric by
+// name, so readers need no knowledge of the writer. Every metric starts on
+// its own cache line and is updated with a relaxed atomic add.
+class metrics_region {
+public:
+  using size_type = mapped_file::size_type;
+  using value_type = std::atomic<std::uint64_t>;
+
+  static constexpr size_type cache_line = 64;
+  static constexpr std::size_t name_size = 48;
+  // bucket i of a histogram counts values of bit width i
+  static constexpr std::uint32_t histogram_buckets = 65;
+  static constexpr std::uint32_t version = 1;
+  static constexpr std::uint64_t magic = 0x63697274656d6f69; // "iometric"
+
+  enum class metric_kind : std::uint32_t { counter = 1, histogram = 2 };
+
+
+  class counter {
+  public:
+    friend class metrics_region;
+
+    counter() noexcept = default;
+    explicit operator bool () const noexcept { return value_ != nullptr; }
+
+    void add(std::uint64_t n = 1) noexcept {
+      value_->fetch_add(n, std::memory_order_relaxed);
+    }
+
+    std::uint64_t value() const noexcept {
+      return value_->load(std::memory_order_relaxed);
+    }
+
+  private:
+    value_type* value_{nullptr};
+    explicit counter(value_type* value) noexcept: value_{value} { }
+  }; // counter
+
+
+  class histogram {
+  public:
+    friend class metrics_region;
+
+    histogram() noexcept = default;
+    explicit operator bool () const noexcept { return values_ != nullptr; }
+
+    void record(std::uint64_t value) noexcept {
+      values_[0].fetch_add(1, std::memory_order_relaxed);
+      values_[1].fetch_add(value, std::memory_order_relaxed);
+      values_[2 + bit_width(value)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::uint64_t count() const noexcept {
+      return values_[0].load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t sum() const noexcept {
+      return values_[1].load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t bucket(std::uint32_t i) const noexcept {
+      return values_[2 + i].load(std::memory_order_relaxed);
+    }
+
+  private:
+    value_type* values_{nullptr};
+    explicit histogram(value_type* values) noexcept: values_{values} { }
+
+    static std::uint32_t bit_width(std::uint64_t value) noexcept {
+      std::uint32_t result = 0;
+      while(value != 0) {
+        value >>= 1;
+        ++result;
+      }
+      return result;
+    }
+  }; // histogram
+
+
+  struct entry {
+    std::string_view name;
+    metric_kind kind;
+    // counter: the value; histogram: count, sum and then the buckets
+    value_type const* values;
+    std::uint32_t size;
+  };
+
+
+  static metrics_region create(std::filesystem::path const& path,
+                               std::uint32_t capacity) noexcept {
+    metrics_region result;
+    {
+      auto f = file::create(path);
+      if(!f || !f.resize(file_size(capacity)))
+        return result;
+    }
+    result.file_ = mapped_file::open(path.string());
+    if(!result.file_)
+      return result;
+    result.region_ = result.file_.map();
+    if(!result.region_)
+      return result;
+    header_type* const h = result.header();
+    h->magic = magic;
+    h->version = version;
+    h->capacity = capacity;
+    h->data_top = 0;
+    h->count.store(0, std::memory_order_release);
+    return result;
+  }
+
+
+  // Attaches read only to a region created by another process
+  static metrics_region open(std::filesystem::path const& path) noexcept {
+    metrics_region result;
+    result.file_ = mapped_file::open_to_read(path.string());
+    if(!result.file_)
+      return result;
+    result.region_ = result.file_.map();
+    if(!result.region_)
+      return result;
+    header_type const* const h = result.header();
+    if(result.region_.size < size_type(sizeof(header_type)) ||
+       h->magic != magic || h->version != version ||
+       result.region_.size < file_size(h->capacity))
+      result.region_ = mapped_file::region{};
+    return result;
+  }
+
+
+  static std::error_code last_error() noexcept {
+    return mapped_file::last_error();
+  }
+
+
+  metrics_region() noexcept = default;
+
+  explicit operator bool () const noexcept { return !!region_; }
+  std::uint32_t capacity() const noexcept { return header()->capacity; }
+
+
+  std::uint32_t size() const noexcept {
+    return header()->count.load(std::memory_order_acquire);
+  }
+
+
+  counter add_counter(std::string_view name) noexcept {
+    return counter{add(name, metric_kind::counter, 1)};
+  }
+
+
+  histogram add_histogram(std::string_view name) noexcept {
+    return histogram{add(name, metric_kind::histogram, 2 + histogram_buckets)};
+  }
+
+
+  entry at(std::uint32_t i) const noexcept {
+    descriptor_type const& d = descriptors()[i];
+    auto const length = std::find(d.name, d.name + name_size, '\0') - d.name;
+    return entry{std::string_view{d.name, std::size_t(length)},
+                 metric_kind(d.kind),
+                 reinterpret_cast<value_type const*>(data() + d.offset),
+                 d.size};
+  }
+
+private:
+
+  struct header_type {
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t capacity;
+    std::atomic<std::uint32_t> count;
+    std::uint32_t reserved;
+    std::uint64_t data_top;
+  };
+
+  struct descriptor_type {
+    char name[name_size];
+    std::uint32_t kind;
+    std::uint32_t size;
+    std::uint64_t offset;
+  };
+
+  static_assert(sizeof(header_type) <= cache_line);
+  static_assert(sizeof(descriptor_type) == cache_line);
+  static_assert(value_type::is_always_lock_free);
+
+  mapped_file file_;
+  mapped_file::region region_;
+
+
+  static size_type lines(std::uint32_t values) noexcept {
+    return (values * size_type(sizeof(value_type)) + cache_line - 1) / cache_line;
+  }
+
+
+  static size_type file_size(std::uint32_t capacity) noexcept {
+    // enough room for capacity histograms, the largest kind of metric
+    return cache_line * (1 + capacity * (1 + lines(2 + histogram_buckets)));
+  }
+
+
+  header_type* header() const noexcept {
+    return reinterpret_cast<header_type*>(region_.address);
+  }
+
+
+  descriptor_type* descriptors() const noexcept {
+    return reinterpret_cast<descriptor_type*>(region_.address + cache_line);
+  }
+
+
+  char* data() const noexcept {
+    return region_.address + cache_line * (1 + header()->capacity);
+  }
+
+
+  // Single writer: the descriptor is filled before count publishes it
+  value_type* add(std::string_view name, metric_kind kind,
+                  std::uint32_t values) noexcept {
+    if(!region_ || file_.read_only())
+      return nullptr;
+    header_type* const h = header();
+    auto const i = h->count.load(std::memory_order_relaxed);
+    if(i == h->capacity)
+      return nullptr;
+    descriptor_type& d = descriptors()[i];
+    std::memset(d.name, 0, name_size);
+    std::memcpy(d.name, name.data(), name.size() < name_size ? name.size() : name_size);
+    d.kind = std::uint32_t(kind);
+    d.size = values;
+    d.offset = h->data_top;
+    h->data_top += std::uint64_t(lines(values) * cache_line);
+    auto* const result = reinterpret_cast<value_type*>(data() + d.offset);
+    for(std::uint32_t v = 0; v != values; ++v)
+      new(result + v) value_type{0};
+    h->count.store(i + 1, std::memory_order_release);
+    return result;
+  }
+
+}; // metrics_region
+
+
+} // iofet
@@ -0,0 +1,341 @@
+/* This file is part of iofet library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+
+#include "file.hpp"
+#include "mapped_file.hpp"
+
+
+#ifdef _WIN32
+
+#if !defined(_X86_) && !defined(_AMD64_) && !defined(_ARM_) && !defined(_ARM64_)
+#if defined(_M_IX86)
+#define _X86_
+#elif defined(_M_AMD64)
+#define _AMD64_
+#elif defined(_M_ARM)
+#define _ARM_
+#elif defined(_M_ARM64)
+#define _ARM64_
+#endif
+#endif
+
+#include <minwindef.h>
+#include <memoryapi.h>
+#include <handleapi.h>
+#include <processthreadsapi.h>
+
+#pragma comment(lib, "onecore.lib")
+
+#else
+
+#include <sys/mman.h>
+
+#endif // WIN32
+
+
+namespace iofet {
+
+
+// Single producer, single consumer byte ring living in a file. The data
+// pages are mapped twice back to back, so any record up to capacity()
+// bytes is contiguous in memory however it wraps. Head and tail counters
+// sit in a header page in front of the data and may be shared between
+// processes mapping the same file.
+class mirrored_ring {
+public:
+  using size_type = mapped_file::size_type;
+
+  static constexpr size_type cache_line = 64;
+  static constexpr std::uint64_t magic = 0x676e697274656f69; // "ioetring"
+
+
+  static mirrored_ring create(std::filesystem::path const& path,
+                              size_type capacity) noexcept {
+    mirrored_ring result;
+    result.file_ = file::create(path);
+    if(!result.file_)
+      return result;
+    auto const granularity = mapped_file::granularity();
+    capacity = (capacity + granularity - 1) / granularity * granularity;
+    if(!result.file_.resize(header_size() + capacity))
+      return result;
+    if(!result.map(capacity))
+      return result;
+    header_type* const header = result.header_;
+    header->magic = magic;
+    header->capacity = std::uint64_t(capacity);
+    header->head.store(0, std::memory_order_relaxed);
+    header->tail.store(0, std::memory_order_release);
+    return result;
+  }
+
+
+  static mirrored_ring open(std::filesystem::path const& path) noexcept {
+    mirrored_ring result;
+    result.file_ = file::open_to_rw(path);
+    if(!result.file_)
+      return result;
+    auto const size = result.file_.size();
+    if(!size || *size <= header_size())
+      return result;
+    size_type const capacity = *size - header_size();
+    if(capacity % mapped_file::granularity() != 0 || !result.map(capacity))
+      return result;
+    if(result.header_->magic != magic ||
+       result.header_->capacity != std::uint64_t(capacity))
+      result.unmap();
+    return result;
+  }
+
+
+  static std::error_code last_error() noexcept {
+    return file::last_error();
+  }
+
+
+  mirrored_ring() noexcept = default;
+  ~mirrored_ring() noexcept { unmap(); }
+  mirrored_ring(mirrored_ring const&) = delete;
+  mirrored_ring& operator = (mirrored_ring const&) = delete;
+
+
+  mirrored_ring(mirrored_ring&& other) noexcept:
+    file_{std::move(other.file_)}, header_{other.header_},
+    data_{other.data_}, capacity_{other.capacity_} {
+    other.header_ = nullptr;
+    other.data_ = nullptr;
+  }
+
+
+  mirrored_ring& operator = (mirrored_ring&& other) noexcept {
+    unmap();
+    file_ = std::move(other.file_);
+    header_ = other.header_; other.header_ = nullptr;
+    data_ = other.data_; other.data_ = nullptr;
+    capacity_ = other.capacity_;
+    return *this;
+  }
+
+
+  explicit operator bool () const noexcept { return data_ != nullptr; }
+  size_type capacity() const noexcept { return capacity_; }
+
+
+  // Producer side
+
+  size_type writable() const noexcept {
+    auto const head = header_->head.load(std::memory_order_acquire);
+    auto const tail = header_->tail.load(std::memory_order_relaxed);
+    return capacity_ - size_type(tail - head);
+  }
+
+
+  // Contiguous space for n bytes at the tail or nullptr if the ring is full
+  char* prepare(size_type n) noexcept {
+    if(n > writable())
+      return nullptr;
+    auto const tail = header_->tail.load(std::memory_order_relaxed);
+    return data_ + tail % std::uint64_t(capacity_);
+  }
+
+
+  void commit(size_type n) noexcept {
+    auto const tail = header_->tail.load(std::memory_order_relaxed);
+    header_->tail.store(tail + std::uint64_t(n), std::memory_order_release);
+  }
+
+
+  bool write(char const* data, size_type n) noexcept {
+    char* const target = prepare(n);
+    if(target == nullptr)
+      return false;
+    std::memcpy(target, data, size_t(n));
+    commit(n);
+    return true;
+  }
+
+
+  // Consumer side
+
+  size_type readable() const noexcept {
+    auto const tail = header_->tail.load(std::memory_order_acquire);
+    auto const head = header_->head.load(std::memory_order_relaxed);
+    return size_type(tail - head);
+  }
+
+
+  // Contiguous readable() bytes at the head
+  char const* peek() const noexcept {
+    auto const head = header_->head.load(std::memory_order_relaxed);
+    return data_ + head % std::uint64_t(capacity_);
+  }
+
+
+  void consume(size_type n) noexcept {
+    auto const head = header_->head.load(std::memory_order_relaxed);
+    header_->head.store(head + std::uint64_t(n), std::memory_order_release);
+  }
+
+
+  bool read(char* data, size_type n) noexcept {
+    if(n > readable())
+      return false;
+    std::memcpy(data, peek(), size_t(n));
+    consume(n);
+    return true;
+  }
+
+private:
+
+  struct header_type {
+    std::uint64_t magic;
+    std::uint64_t capacity;
+    alignas(cache_line) std::atomic<std::uint64_t> head;
+    alignas(cache_line) std::atomic<std::uint64_t> tail;
+  };
+
+  // counters are shared with other processes through the file
+  static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+  file file_;
+  header_type* header_{nullptr};
+  char* data_{nullptr};
+  size_type capacity_{0};
+
+
+  static size_type header_size() noexcept {
+    return mapped_file::granularity();
+  }
+
+
+#ifdef _WIN32
+
+  bool map(size_type capacity) noexcept {
+    HANDLE const mapping = CreateFileMappingW(file_.handle_, nullptr,
+                                              PAGE_READWRITE, 0, 0, nullptr);
+    if(mapping == nullptr)
+      return false;
+    void* const header = MapViewOfFile(mapping, FILE_MAP_READ | FILE_MAP_WRITE,
+                                       0, 0, SIZE_T(header_size()));
+    char* const base = header == nullptr ? nullptr : static_cast<char*>(
+        VirtualAlloc2(nullptr, nullptr, SIZE_T(2 * capacity),
+                      MEM_RESERVE | MEM_RESERVE_PLACEHOLDER, PAGE_NOACCESS,
+                      nullptr, 0));
+    // split the placeholder in two halves, one per view
+    bool const split = base != nullptr &&
+        VirtualFree(base, SIZE_T(capacity), MEM_RELEASE | MEM_PRESERVE_PLACEHOLDER);
+    void* first = nullptr;
+    void* second = nullptr;
+    if(split) {
+      first = MapViewOfFile3(mapping, GetCurrentProcess(), base,
+                             ULONG64(header_size()), SIZE_T(capacity),
+                             MEM_REPLACE_PLACEHOLDER, PAGE_READWRITE, nullptr, 0);
+      second = MapViewOfFile3(mapping, GetCurrentProcess(), base + capacity,
+                              ULONG64(header_size()), SIZE_T(capacity),
+                              MEM_REPLACE_PLACEHOLDER, PAGE_READWRITE, nullptr, 0);
+    }
+    CloseHandle(mapping);
+    if(first != nullptr && second != nullptr) {
+      header_ = static_cast<header_type*>(header);
+      data_ = base;
+      capacity_ = capacity;
+      return true;
+    }
+    if(first != nullptr)
+      UnmapViewOfFile(first);
+    else if(base != nullptr)
+      VirtualFree(base, 0, MEM_RELEASE);
+    if(second != nullptr)
+      UnmapViewOfFile(second);
+    else if(split)
+      VirtualFree(base + capacity, 0, MEM_RELEASE);
+    if(header != nullptr)
+      UnmapViewOfFile(header);
+    return false;
+  }
+
+
+  void unmap() noexcept {
+    if(header_ != nullptr)
+      UnmapViewOfFile(header_);
+    if(data_ != nullptr) {
+      UnmapViewOfFile(data_);
+      UnmapViewOfFile(data_ + capacity_);
+    }
+    header_ = nullptr;
+    data_ = nullptr;
+  }
+
+#else
+
+  bool map(size_type capacity) noexcept {
+    void* const header = ::mmap(nullptr, size_t(header_size()),
+                                PROT_READ | PROT_WRITE, MAP_SHARED,
+                                file_.handle_, 0);
+    if(header == MAP_FAILED)
+      return false;
+    void* const base = ::mmap(nullptr, size_t(2 * capacity), PROT_NONE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if(base == MAP_FAILED) {
+      ::munmap(header, size_t(header_size()));
+      return false;
+    }
+    char* const data = static_cast<char*>(base);
+    for(char* half: {data, data + capacity})
+      if(::mmap(half, size_t(capacity), PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_FIXED, file_.handle_,
+                off_t(header_size())) == MAP_FAILED) {
+        ::munmap(base, size_t(2 * capacity));
+        ::munmap(header, size_t(header_size()));
+        return false;
+      }
+    header_ = static_cast<header_type*>(header);
+    data_ = data;
+    capacity_ = capacity;
+    return true;
+  }
+
+
+  void unmap() noexcept {
+    if(header_ != nullptr)
+      ::munmap(header_, size_t(header_size()));
+    if(data_ != nullptr)
+      ::munmap(data_, size_t(2 * capacity_));
+    header_ = nullptr;
+    data_ = nullptr;
+  }
+
+#endif // _WIN32
+
+}; // mirrored_ring
+
+
+} // iofet
@@ -0,0 +1,258 @@
+/* This file is part of iofet library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "glob.hpp"
+
+
+namespace iofet {
+
+
+// Set of file name masks matched together. The longest literal of every mask
+// goes into one Aho-Corasick automaton, so a single pass over the name finds
+// the literals it contains however many masks there are; only masks whose
+// literal was found (and masks without any literal, such as "*") are then
+// checked as a whole. The automaton runs over classes of the characters that
+// occur in the literals, all other characters share class 0.
+template<typename C>
+class basic_multi_glob {
+public:
+  using value_type = C;
+  using string_type = std::basic_string<C>;
+  using view_type = std::basic_string_view<C>;
+  using glob_type = basic_glob<C>;
+
+
+  basic_multi_glob() {
+    compile();
+  }
+
+  explicit basic_multi_glob(std::vector<string_type> masks) {
+    globs_.reserve(masks.size());
+    for(auto& mask: masks)
+      globs_.emplace_back(std::move(mask));
+    compile();
+  }
+
+
+  std::size_t size() const noexcept { return globs_.size(); }
+
+  glob_type const& operator [] (std::size_t i) const noexcept {
+    return globs_[i];
+  }
+
+
+  // Fills result with the indices of the matching masks in ascending order
+  bool matches(view_type text, std::vector<std::size_t>& result) const {
+    result.clear();
+    std::uint32_t state = 0;
+    for(C const c: text) {
+      state = next_[state * classes_ + class_of(c)];
+      for(auto i = output_begin_[state]; i != output_begin_[state + 1]; ++i)
+        result.push_back(outputs_[i]);
+    }
+    // literals found, then the masks behind them appended and the literals dropped
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    std::size_t const keys = result.size();
+    for(std::size_t k = 0; k != keys; ++k) {
+      std::size_t const key = result[k];
+      for(auto i = key_begin_[key]; i != key_begin_[key + 1]; ++i)
+        if(globs_[key_masks_[i]].matches(text))
+          result.push_back(key_masks_[i]);
+    }
+    for(auto const i: unkeyed_)
+      if(globs_[i].matches(text))
+        result.push_back(i);
+    result.erase(result.begin(), result.begin() + keys);
+    std::sort(result.begin(), result.end());
+    return !result.empty();
+  }
+
+
+  bool matches(C const* text, std::vector<std::size_t>& result) const {
+    return matches(view_type{text}, result);
+  }
+
+
+  bool matches_any(view_type text) const noexcept {
+    std::uint32_t state = 0;
+    for(C const c: text) {
+      state = next_[state * classes_ + class_of(c)];
+      for(auto i = output_begin_[state]; i != output_begin_[state + 1]; ++i) {
+        std::size_t const key = outputs_[i];
+        for(auto j = key_begin_[key]; j != key_begin_[key + 1]; ++j)
+          if(globs_[key_masks_[j]].matches(text))
+            return true;
+      }
+    }
+    for(auto const i: unkeyed_)
+      if(globs_[i].matches(text))
+        return true;
+    return false;
+  }
+
+
+  bool matches_any(C const* text) const noexcept {
+    return matches_any(view_type{text});
+  }
+
+private:
+  using unsigned_type = std::make_unsigned_t<C>;
+
+  std::vector<glob_type> globs_;
+  // masks without a literal, checked against every name
+  std::vector<std::size_t> unkeyed_;
+  // masks of literal k are key_masks_[key_begin_[k], key_begin_[k + 1])
+  std::vector<std::size_t> key_begin_;
+  std::vector<std::size_t> key_masks_;
+
+  std::array<std::uint32_t, 256> byte_class_{};
+  // classes of characters above 255, sorted
+  std::vector<std::pair<unsigned_type, std::uint32_t>> wide_class_;
+  std::size_t classes_{1};
+  // transitions, failure links folded in: next_[state * classes_ + class]
+  std::vector<std::uint32_t> next_;
+  // literals ending in a state, its suffix states included
+  std::vector<std::uint32_t> output_begin_;
+  std::vector<std::uint32_t> outputs_;
+
+
+  std::size_t class_of(C c) const noexcept {
+    auto const u = unsigned_type(c);
+    if constexpr(sizeof(C) == 1)
+      return byte_class_[u];
+    else {
+      if(u < 256)
+        return byte_class_[u];
+      auto const found = std::lower_bound(
+          wide_class_.begin(), wide_class_.end(), u,
+          [](auto const& entry, unsigned_type value) { return entry.first < value; });
+      return found != wide_class_.end() && found->first == u ? found->second : 0;
+    }
+  }
+
+
+  void add_class(C c) {
+    auto const u = unsigned_type(c);
+    if(u < 256) {
+      if(byte_class_[u] == 0)
+        byte_class_[u] = std::uint32_t(classes_++);
+      return;
+    }
+    auto const found = std::lower_bound(
+        wide_class_.begin(), wide_class_.end(), u,
+        [](auto const& entry, unsigned_type value) { return entry.first < value; });
+    if(found == wide_class_.end() || found->first != u)
+      wide_class_.emplace(found, u, std::uint32_t(classes_++));
+  }
+
+
+  void compile() {
+    std::map<view_type, std::vector<std::size_t>> keyed;
+    for(std::size_t i = 0; i != globs_.size(); ++i) {
+      view_type const key = globs_[i].required_literal();
+      if(key.empty())
+        unkeyed_.push_back(i);
+      else
+        keyed[key].push_back(i);
+    }
+
+    std::vector<view_type> keys;
+    key_begin_.push_back(0);
+    for(auto const& [key, masks]: keyed) {
+      keys.push_back(key);
+      key_masks_.insert(key_masks_.end(), masks.begin(), masks.end());
+      key_begin_.push_back(key_masks_.size());
+      for(C const c: key)
+        add_class(c);
+    }
+
+    // trie of the literals, 0 is the root and never a child
+    std::vector<std::uint32_t> trie(classes_, 0);
+    std::vector<std::vector<std::uint32_t>> output(1);
+    for(std::size_t k = 0; k != keys.size(); ++k) {
+      std::uint32_t state = 0;
+      for(C const c: keys[k]) {
+        auto& child = trie[state * classes_ + class_of(c)];
+        if(child == 0) {
+          child = std::uint32_t(output.size());
+          output.emplace_back();
+          trie.resize(trie.size() + classes_, 0);
+        }
+        state = trie[state * classes_ + class_of(c)];
+      }
+      output[state].push_back(std::uint32_t(k));
+    }
+
+    // breadth first, so failure states are complete before they are used
+    std::size_t const states = output.size();
+    next_.assign(states * classes_, 0);
+    std::vector<std::uint32_t> failure(states, 0);
+    std::vector<std::uint32_t> queue{0};
+    for(std::size_t q = 0; q != queue.size(); ++q) {
+      std::uint32_t const state = queue[q];
+      for(std::size_t c = 0; c != classes_; ++c) {
+        std::uint32_t const child = trie[state * classes_ + c];
+        std::uint32_t const fallback =
+            state == 0 ? 0 : next_[failure[state] * classes_ + c];
+        if(child == 0) {
+          next_[state * classes_ + c] = fallback;
+          continue;
+        }
+        next_[state * classes_ + c] = child;
+        failure[child] = fallback;
+        auto const& inherited = output[fallback];
+        output[child].insert(output[child].end(), inherited.begin(), inherited.end());
+        queue.push_back(child);
+      }
+    }
+
+    output_begin_.push_back(0);
+    for(auto const& list: output) {
+      outputs_.insert(outputs_.end(), list.begin(), list.end());
+      output_begin_.push_back(std::uint32_t(outputs_.size()));
+    }
+  }
+
+}; // basic_multi_glob
+
+
+using multi_glob = basic_multi_glob<std::filesystem::path::value_type>;
+
+
+} // iofet
@@ -0,0 +1,148 @@
+/* This file is part of iofet library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "directory_mask_iterator.hpp"
+#include "multi_glob.hpp"
+
+
+namespace iofet {
+
+
+  // Single pass over a directory for a set of masks; matched() tells which
+  // of them the current entry satisfies
+  class multi_mask_iterator {
+  public:
+
+    using value_type = std::filesystem::directory_entry;
+    using pointer = std::filesystem::directory_entry const*;
+    using reference = std::filesystem::directory_entry const&;
+    using iterator_category = std::input_iterator_tag;
+
+    multi_mask_iterator() noexcept = default;
+
+
+    multi_mask_iterator(std::filesystem::path const& path,
+                        std::vector<std::string> const& masks,
+                        std::error_code& ec):
+      multi_mask_iterator{path, std::filesystem::directory_options::none, masks, ec}
+    { }
+
+
+    multi_mask_iterator(std::filesystem::path const& path,
+                        std::filesystem::directory_options options,
+                        std::vector<std::string> const& masks,
+                        std::error_code& ec):
+      multi_mask_iterator{path, options, std::make_shared<multi_glob const>(native(masks)), ec}
+    { }
+
+
+    // The same compiled set may be shared by many iterators
+    multi_mask_iterator(std::filesystem::path const& path,
+                        std::filesystem::directory_options options,
+                        std::shared_ptr<multi_glob const> masks,
+                        std::error_code& ec):
+      it_{path, options, ec}, masks_{std::move(masks)}
+    {
+      if (it_ == end(it_))
+        return;
+      if (masks_->matches(detail::filename_of(it_->path()), matched_))
+        return;
+      operator ++ ();
+    }
+
+
+    bool operator == (multi_mask_iterator const& other) const noexcept {
+      return it_ == other.it_;
+    }
+
+
+    bool operator != (multi_mask_iterator const& other) const noexcept {
+      return it_ != other.it_;
+    }
+
+
+    multi_mask_iterator& operator ++ () {
+      std::error_code ec;
+      for(;;) {
+        it_.increment(ec);
+        if(it_ == end(it_)) {
+          matched_.clear();
+          return *this;
+        }
+        if(masks_->matches(detail::filename_of(it_->path()), matched_))
+          return *this;
+      }
+    }
+
+
+    std::filesystem::directory_entry const& operator * () const {
+      return it_.operator * ();
+    }
+
+
+    std::filesystem::directory_entry const* operator -> () const {
+      return it_.operator -> ();
+    }
+
+
+    // Indices of the masks matching the current entry, ascending
+    std::vector<std::size_t> const& matched() const noexcept {
+      return matched_;
+    }
+
+  private:
+    std::filesystem::directory_iterator it_;
+    std::shared_ptr<multi_glob const> masks_;
+    std::vector<std::size_t> matched_;
+
+
+    static multi_glob native(std::vector<std::string> const& masks) {
+      std::vector<std::filesystem::path::string_type> result;
+      result.reserve(masks.size());
+      for(auto const& mask: masks)
+        result.push_back(std::filesystem::path{mask}.native());
+      return multi_glob{std::move(result)};
+    }
+  };
+
+
+  inline multi_mask_iterator begin(multi_mask_iterator const& iter) noexcept {
+    return iter;
+  }
+
+
+  inline multi_mask_iterator end(multi_mask_iterator const&) noexcept {
+    return multi_mask_iterator{};
+  }
+
+}
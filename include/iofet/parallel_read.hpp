@@ -0,0 +1,197 @@
+/* This file is part of iofet library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "file.hpp"
+
+
+namespace iofet {
+
+
+namespace detail {
+
+  // Chunks start at multiples of this, so they stay aligned to device blocks
+  constexpr file::size_type read_alignment = 4096;
+
+
+  inline unsigned read_threads(unsigned threads) noexcept {
+    if(threads != 0)
+      return threads;
+    unsigned const hardware = std::thread::hardware_concurrency();
+    return hardware != 0 ? hardware : 1;
+  }
+
+
+  inline file::size_type aligned_chunk(file::size_type chunk) noexcept {
+    if(chunk < read_alignment)
+      return read_alignment;
+    return (chunk + read_alignment - 1) / read_alignment * read_alignment;
+  }
+
+} // detail
+
+
+constexpr file::size_type default_read_chunk = 4 * 1024 * 1024;
+
+
+// Fills buffer with the first size bytes of f using positional reads
+// issued by threads workers at once, each taking the next chunk in turn.
+// Deep queues are what it takes to saturate NVMe drives.
+inline bool parallel_read(file& f, char* buffer, file::size_type size,
+                          unsigned threads = 0,
+                          file::size_type chunk = default_read_chunk) {
+  chunk = detail::aligned_chunk(chunk);
+  file::size_type const chunks = (size + chunk - 1) / chunk;
+  std::atomic<file::size_type> next{0};
+  std::atomic<bool> failed{false};
+
+  auto const work = [&] {
+    for(;;) {
+      file::size_type const i = next.fetch_add(1, std::memory_order_relaxed);
+      if(i >= chunks || failed.load(std::memory_order_relaxed))
+        return;
+      file::offset_type const offset = i * chunk;
+      file::size_type const n = std::min(chunk, size - offset);
+      if(!f.read_at(offset, buffer + offset, n))
+        failed.store(true, std::memory_order_relaxed);
+    }
+  };
+
+  threads = unsigned(std::min<file::size_type>(detail::read_threads(threads), chunks));
+  std::vector<std::thread> workers;
+  for(unsigned t = 1; t < threads; ++t)
+    workers.emplace_back(work);
+  work();
+  for(auto& worker: workers)
+    worker.join();
+  return !failed.load();
+}
+
+
+// Reads the first size bytes of f in chunks delivered in file order to
+// consume(offset, char const* data, size) on the calling thread while
+// workers already read the following ones. At most two chunks per worker
+// are buffered, whatever the file size. Returns false when a read fails
+// or consume returns false; an exception from consume is rethrown once the
+// workers have stopped.
+template<typename F>
+bool parallel_read(file& f, file::size_type size, F&& consume,
+                   unsigned threads = 0,
+                   file::size_type chunk = default_read_chunk) {
+  chunk = detail::aligned_chunk(chunk);
+  file::size_type const chunks = (size + chunk - 1) / chunk;
+  threads = detail::read_threads(threads);
+  file::size_type const window = std::min<file::size_type>(2 * threads, chunks);
+  if(window == 0)
+    return true;
+
+  enum class state { free, reading, ready, failed };
+  std::unique_ptr<char[]> storage{new char[size_t(window * chunk)]};
+  std::vector<state> slots(size_t(window), state::free);
+  std::mutex mutex;
+  std::condition_variable changed;
+  file::size_type claimed = 0;   // next chunk to be read
+  file::size_type delivered = 0; // next chunk to be consumed
+  bool stopped = false;
+
+  auto const work = [&] {
+    for(;;) {
+      file::size_type i;
+      {
+        std::unique_lock<std::mutex> lock{mutex};
+        changed.wait(lock, [&] {
+          return stopped || claimed == chunks || claimed < delivered + window;
+        });
+        if(stopped || claimed == chunks)
+          return;
+        i = claimed++;
+        slots[size_t(i % window)] = state::reading;
+      }
+      file::offset_type const offset = i * chunk;
+      file::size_type const n = std::min(chunk, size - offset);
+      bool const ok = f.read_at(offset, storage.get() + (i % window) * chunk, n);
+      {
+        std::lock_guard<std::mutex> lock{mutex};
+        slots[size_t(i % window)] = ok ? state::ready : state::failed;
+      }
+      changed.notify_all();
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for(unsigned t = 0; t != threads; ++t)
+    workers.emplace_back(work);
+
+  bool ok = true;
+  for(file::size_type i = 0; i != chunks && ok; ++i) {
+    state* const slot = &slots[size_t(i % window)];
+    {
+      std::unique_lock<std::mutex> lock{mutex};
+      changed.wait(lock, [&] {
+        return *slot == state::ready || *slot == state::failed;
+      });
+      ok = *slot == state::ready;
+    }
+    file::offset_type const offset = i * chunk;
+    if(ok) {
+      try {
+        ok = consume(offset, static_cast<char const*>(storage.get() + (i % window) * chunk),
+                     std::min(chunk, size - offset));
+      } catch(...) {
+        // workers are stopped and joined before the exception leaves
+        {
+          std::lock_guard<std::mutex> lock{mutex};
+          stopped = true;
+        }
+        changed.notify_all();
+        for(auto& worker: workers)
+          worker.join();
+        throw;
+      }
+    }
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      *slot = state::free;
+      ++delivered;
+      stopped = !ok;
+    }
+    changed.notify_all();
+  }
+
+  for(auto& worker: workers)
+    worker.join();
+  return ok;
+}
+
+
+} // iofet
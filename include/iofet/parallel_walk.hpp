@@ -0,0 +1,250 @@
+/* This file is part of iofet library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "directory_mask_iterator.hpp"
+#include "directory_reader.hpp"
+#include "file.hpp"
+#include "glob.hpp"
+
+
+namespace iofet {
+
+
+namespace detail {
+
+  // Smaller than a directory_reader default, one is allocated per directory
+  constexpr std::size_t walk_buffer = 64 * 1024;
+
+
+  // Calls entry(name, directory) for every entry but "." and "..". Entry
+  // types come from the directory listing itself; only file systems that do
+  // not report them cost a stat. Symlinks are never taken for directories.
+  template<typename F>
+  bool list_directory(std::filesystem::path const& directory, F&& entry) {
+#ifdef _WIN32
+    std::error_code ec;
+    std::filesystem::directory_iterator it{directory, ec};
+    if(!!ec)
+      return false;
+    for(std::filesystem::directory_iterator const last; it != last; it.increment(ec)) {
+      if(!!ec)
+        return false;
+      std::error_code type_ec;
+      bool const is_directory = it->is_directory(type_ec) && !it->is_symlink(type_ec);
+      entry(filename_of(it->path()), is_directory);
+    }
+    return true;
+#else
+    auto reader = directory_reader::open(directory, walk_buffer);
+    if(!reader)
+      return false;
+    directory_reader::entry e;
+    while(reader.next(e))
+      // names are NUL terminated in the reader buffer
+      entry(e.name.data(), reader.type_of(e) == directory_reader::entry_type::directory);
+    // next also stops when getdents64 fails partway
+    return !directory_reader::last_error();
+#endif // _WIN32
+  }
+
+
+  struct walk_queue {
+    std::mutex mutex;
+    std::deque<std::filesystem::path> directories;
+  };
+
+} // detail
+
+
+// Names handed to one call of the parallel_walk callback at most
+constexpr std::size_t walk_batch = 1024;
+
+
+// Walks the tree under root with threads workers, the calling thread being
+// one of them. Each worker lists directories from the back of its own
+// queue and, once it runs dry, steals from the front of the others', so
+// large subtrees spread over the pool while per-directory latency overlaps.
+// Workers finding every queue empty sleep until more directories are pushed
+// rather than spin while a slow directory is being listed.
+// Names matching mask are passed as
+//
+//   fn(unsigned thread, std::filesystem::path const& directory,
+//      std::vector<std::filesystem::path::string_type> const& names)
+//
+// from the worker that listed the directory, concurrently with the other
+// workers; thread lets fn keep per worker state without locks. Symlinks are
+// not followed and unreadable directories are skipped. Returns false when
+// root is not a readable directory. When fn throws, the walk stops and the
+// first exception is rethrown once every worker has finished.
+template<typename F>
+bool parallel_walk(std::filesystem::path const& root, glob const& mask, F&& fn,
+                   unsigned threads = 0) {
+  threads = threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+  std::unique_ptr<detail::walk_queue[]> queues{new detail::walk_queue[threads]};
+  queues[0].directories.push_back(root);
+  // directories queued or being listed
+  std::atomic<std::size_t> pending{1};
+  std::atomic<bool> root_listed{true};
+  // idle workers sleep until directories are pushed or the walk is over
+  std::mutex idle_mutex;
+  std::condition_variable idle;
+  std::atomic<std::uint64_t> pushes{0};
+  // set once fn throws; the first exception is rethrown after the join
+  std::atomic<bool> stopped{false};
+  std::exception_ptr failure;
+
+  auto const take = [&](unsigned t) -> std::optional<std::filesystem::path> {
+    for(unsigned i = 0; i != threads; ++i) {
+      auto& queue = queues[(t + i) % threads];
+      std::lock_guard<std::mutex> lock{queue.mutex};
+      if(queue.directories.empty())
+        continue;
+      std::filesystem::path result;
+      if(i == 0) {
+        result = std::move(queue.directories.back());
+        queue.directories.pop_back();
+      } else {
+        result = std::move(queue.directories.front());
+        queue.directories.pop_front();
+      }
+      return result;
+    }
+    return std::nullopt;
+  };
+
+  auto const work = [&](unsigned t) {
+    std::vector<std::filesystem::path::string_type> names;
+    std::vector<std::filesystem::path> children;
+    while(!stopped.load(std::memory_order_relaxed)) {
+      // read before looking at the queues, so a push made after the look
+      // is not slept through
+      auto const seen = pushes.load(std::memory_order_acquire);
+      auto const directory = take(t);
+      if(!directory) {
+        std::unique_lock<std::mutex> lock{idle_mutex};
+        idle.wait(lock, [&] {
+          return stopped.load(std::memory_order_relaxed) ||
+                 pending.load(std::memory_order_acquire) == 0 ||
+                 pushes.load(std::memory_order_relaxed) != seen;
+        });
+        if(pending.load(std::memory_order_acquire) == 0)
+          return;
+        continue;
+      }
+      names.clear();
+      children.clear();
+      bool const listed = detail::list_directory(*directory,
+          [&](std::filesystem::path::value_type const* name, bool is_directory) {
+            if(is_directory)
+              children.push_back(*directory / name);
+            if(!mask.matches(name))
+              return;
+            names.emplace_back(name);
+            if(names.size() == walk_batch) {
+              fn(t, *directory, names);
+              names.clear();
+            }
+          });
+      if(!listed && directory->native() == root.native())
+        root_listed.store(false, std::memory_order_relaxed);
+      if(!names.empty())
+        fn(t, *directory, names);
+      if(!children.empty()) {
+        pending.fetch_add(children.size(), std::memory_order_relaxed);
+        {
+          std::lock_guard<std::mutex> lock{queues[t].mutex};
+          for(auto& child: children)
+            queues[t].directories.push_back(std::move(child));
+        }
+        {
+          std::lock_guard<std::mutex> lock{idle_mutex};
+          pushes.fetch_add(1, std::memory_order_release);
+        }
+        if(children.size() == 1)
+          idle.notify_one();
+        else
+          idle.notify_all();
+      }
+      if(pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        // taken so the wake up can not fall between a waiter's check and its sleep
+        { std::lock_guard<std::mutex> lock{idle_mutex}; }
+        idle.notify_all();
+      }
+    }
+  };
+
+  auto const run = [&](unsigned t) noexcept {
+    try {
+      work(t);
+    } catch(...) {
+      {
+        std::lock_guard<std::mutex> lock{idle_mutex};
+        if(!failure)
+          failure = std::current_exception();
+        stopped.store(true, std::memory_order_relaxed);
+      }
+      idle.notify_all();
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for(unsigned t = 1; t < threads; ++t)
+    workers.emplace_back(run, t);
+  run(0);
+  for(auto& worker: workers)
+    worker.join();
+  if(failure)
+    std::rethrow_exception(failure);
+  return root_listed.load();
+}
+
+
+template<typename F>
+bool parallel_walk(std::filesystem::path const& root, std::string const& mask, F&& fn,
+                   unsigned threads = 0) {
+  return parallel_walk(root, glob{std::filesystem::path{mask}.native()},
+                       std::forward<F>(fn), threads);
+}
+
+
+} // iofet
@@ -0,0 +1,310 @@
+/* This file is part of iofet library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "directory_mask_iterator.hpp"
+#include "file.hpp"
+#include "glob.hpp"
+
+
+namespace iofet {
+
+  namespace detail {
+
+    // Device and inode, or volume serial number and file index on Windows,
+    // of the directory a path resolves to
+    inline std::optional<std::pair<std::uint64_t, std::uint64_t>>
+    directory_identity(std::filesystem::path const& path) noexcept {
+#ifdef _WIN32
+      HANDLE const handle =
+          CreateFileW(path.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                      nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+      if(handle == INVALID_HANDLE_VALUE)
+        return std::nullopt;
+      BY_HANDLE_FILE_INFORMATION info;
+      BOOL const ok = GetFileInformationByHandle(handle, &info);
+      CloseHandle(handle);
+      if(!ok)
+        return std::nullopt;
+      return std::make_pair(std::uint64_t(info.dwVolumeSerialNumber),
+                            std::uint64_t(info.nFileIndexHigh) << 32 | info.nFileIndexLow);
+#else
+      struct stat st;
+      if(::stat(path.c_str(), &st) == -1)
+        return std::nullopt;
+      return std::make_pair(std::uint64_t(st.st_dev), std::uint64_t(st.st_ino));
+#endif // _WIN32
+    }
+
+  } // detail
+
+
+
+  // Recursive directory_mask_iterator. A mask without separators is matched
+  // against file names at any depth; otherwise it is matched against the
+  // path relative to the root component by component, "**" standing for
+  // any number of directories ("src/**/test_*.cpp"). Directories are not
+  // entered when they match a prune mask, lie deeper than max_depth or can
+  // not lead to a match of a mask with separators. When directory symlinks
+  // are followed, a directory already entered is not entered again.
+  class recursive_mask_iterator {
+  public:
+
+    using value_type = std::filesystem::directory_entry;
+    using pointer = std::filesystem::directory_entry const*;
+    using reference = std::filesystem::directory_entry const&;
+    using iterator_category = std::input_iterator_tag;
+
+    static constexpr std::size_t unlimited = std::numeric_limits<std::size_t>::max();
+
+    struct options {
+      std::filesystem::directory_options directory{std::filesystem::directory_options::none};
+      // directory levels entered below the root, 0 lists the root only
+      std::size_t max_depth{unlimited};
+      // names of directories to skip with everything under them
+      std::vector<std::string> prune;
+    };
+
+
+    recursive_mask_iterator() noexcept = default;
+
+
+    recursive_mask_iterator(std::filesystem::path const& path,
+                            std::string const& mask,
+                            std::error_code& ec):
+      recursive_mask_iterator{path, mask, options{}, ec}
+    { }
+
+
+    recursive_mask_iterator(std::filesystem::path const& path,
+                            std::string const& mask,
+                            options const& settings,
+                            std::error_code& ec):
+      state_{std::make_shared<state>()}
+    {
+      state_->it = std::filesystem::recursive_directory_iterator{path, settings.directory, ec};
+      if(!!ec)
+        return;
+      state_->max_depth = settings.max_depth;
+      state_->follow = (settings.directory &
+                        std::filesystem::directory_options::follow_directory_symlink) !=
+                       std::filesystem::directory_options::none;
+      for(auto const& name: settings.prune)
+        state_->prune.emplace_back(std::filesystem::path{name}.native());
+      compile(mask);
+      if(state_->follow)
+        if(auto const id = detail::directory_identity(path))
+          state_->visited.insert(*id);
+      advance(false);
+    }
+
+
+    bool operator == (recursive_mask_iterator const& other) const noexcept {
+      return at_end() == other.at_end() &&
+             (at_end() || state_->it == other.state_->it);
+    }
+
+
+    bool operator != (recursive_mask_iterator const& other) const noexcept {
+      return !(*this == other);
+    }
+
+
+    recursive_mask_iterator& operator ++ () {
+      advance(true);
+      return *this;
+    }
+
+
+    std::filesystem::directory_entry const& operator * () const {
+      return state_->it.operator * ();
+    }
+
+
+    std::filesystem::directory_entry const* operator -> () const {
+      return state_->it.operator -> ();
+    }
+
+
+    // Directory levels below the root of the current entry
+    std::size_t depth() const {
+      return std::size_t(state_->it.depth());
+    }
+
+  private:
+    using string_type = std::filesystem::path::string_type;
+
+    struct state {
+      std::filesystem::recursive_directory_iterator it;
+      // name mask, or one glob per component where "**" is left empty
+      std::vector<glob> components;
+      std::vector<bool> any_depth;
+      bool by_name{true};
+      std::vector<glob> prune;
+      std::size_t max_depth{unlimited};
+      bool follow{false};
+      std::set<std::pair<std::uint64_t, std::uint64_t>> visited;
+      // names from the root to the current entry
+      std::vector<string_type> names;
+    };
+
+    std::shared_ptr<state> state_;
+
+
+    bool at_end() const noexcept {
+      return !state_ || state_->it == std::filesystem::recursive_directory_iterator{};
+    }
+
+
+    void compile(std::string const& mask) {
+      string_type const native = std::filesystem::path{mask}.native();
+      auto const separator = [](auto c) {
+#ifdef _WIN32
+        return c == '/' || c == '\\';
+#else
+        return c == '/';
+#endif // _WIN32
+      };
+      bool const by_name = std::find_if(native.begin(), native.end(), separator) == native.end();
+      if(by_name) {
+        state_->components.emplace_back(native);
+        state_->any_depth.push_back(false);
+        return;
+      }
+      state_->by_name = false;
+      std::size_t from = 0;
+      for(std::size_t i = 0; i <= native.size(); ++i) {
+        if(i != native.size() && !separator(native[i]))
+          continue;
+        string_type component = native.substr(from, i - from);
+        from = i + 1;
+        if(component.empty())
+          continue;
+        bool const any = component == string_type(2, '*');
+        state_->any_depth.push_back(any);
+        state_->components.emplace_back(any ? string_type{} : std::move(component));
+      }
+    }
+
+
+    // Whether names[j...] match components[i...] completely or, with
+    // partial, whether some deeper path could still complete the match
+    bool matches(std::size_t i, std::size_t j, bool partial) const noexcept {
+      auto const& s = *state_;
+      if(j == s.names.size())
+        return partial ? i != s.components.size() : all_any_depth(i);
+      if(i == s.components.size())
+        return false;
+      if(s.any_depth[i])
+        return matches(i + 1, j, partial) || matches(i, j + 1, partial);
+      return s.components[i].matches(s.names[j]) && matches(i + 1, j + 1, partial);
+    }
+
+
+    bool all_any_depth(std::size_t i) const noexcept {
+      for(; i != state_->components.size(); ++i)
+        if(!state_->any_depth[i])
+          return false;
+      return true;
+    }
+
+
+    bool matched() const noexcept {
+      if(state_->by_name)
+        return state_->components[0].matches(state_->names.back());
+      return matches(0, 0, false);
+    }
+
+
+    bool pruned(string_type const& name) const noexcept {
+      for(auto const& mask: state_->prune)
+        if(mask.matches(name))
+          return true;
+      return false;
+    }
+
+
+    void advance(bool next) {
+      auto& s = *state_;
+      std::filesystem::recursive_directory_iterator const last;
+      std::error_code ec;
+      for(;;) {
+        if(next)
+          s.it.increment(ec);
+        next = true;
+        if(!!ec || s.it == last) {
+          s.it = last;
+          return;
+        }
+        std::size_t const depth = std::size_t(s.it.depth());
+        s.names.resize(depth);
+        s.names.emplace_back(detail::filename_of(s.it->path()));
+        if(s.it->is_directory(ec)) {
+          if(pruned(s.names.back())) {
+            s.it.disable_recursion_pending();
+            continue;
+          }
+          if(depth >= s.max_depth ||
+             (!s.by_name && !matches(0, 0, true)) ||
+             (s.follow && !first_visit(s.it->path())))
+            s.it.disable_recursion_pending();
+        }
+        ec.clear();
+        if(matched())
+          return;
+      }
+    }
+
+
+    bool first_visit(std::filesystem::path const& path) {
+      auto const id = detail::directory_identity(path);
+      return !id || state_->visited.insert(*id).second;
+    }
+  };
+
+
+  inline recursive_mask_iterator begin(recursive_mask_iterator const& iter) noexcept {
+    return iter;
+  }
+
+
+  inline recursive_mask_iterator end(recursive_mask_iterator const&) noexcept {
+    return recursive_mask_iterator{};
+  }
+
+}
@@ -0,0 +1,172 @@
+/* This file is part of iofet library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+
+#include <algorithm>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+#include "mapped_file.hpp"
+
+
+namespace iofet {
+
+
+// Keeps recently used windows of a mapped file mapped, so repeated lookups
+// of hot offsets cost a hash probe instead of mmap/munmap. Windows are
+// evicted in LRU order once more than capacity() bytes are cached; a view
+// handed out keeps its window mapped until the view itself is released.
+class region_cache {
+public:
+  using size_type = mapped_file::size_type;
+  using offset_type = mapped_file::offset_type;
+
+  static constexpr size_type default_window = 1024 * 1024;
+  static constexpr size_type default_capacity = 256 * 1024 * 1024;
+
+
+  class view {
+  public:
+    friend class region_cache;
+
+    view() noexcept = default;
+
+    explicit operator bool () const noexcept { return data_ != nullptr; }
+    char* data() const noexcept { return data_; }
+    size_type size() const noexcept { return size_; }
+
+  private:
+    std::shared_ptr<mapped_file::region> region_;
+    char* data_{nullptr};
+    size_type size_{0};
+
+    view(std::shared_ptr<mapped_file::region> region,
+         char* data, size_type size) noexcept:
+      region_{std::move(region)}, data_{data}, size_{size} { }
+  }; // view
+
+
+  region_cache(mapped_file& file,
+               size_type window = default_window,
+               size_type capacity = default_capacity) noexcept:
+    file_{&file},
+    // at least one granularity unit, get() divides by it
+    window_{round_up(std::max<size_type>(window, 1), mapped_file::granularity())},
+    capacity_{capacity} { }
+
+  region_cache(region_cache const&) = delete;
+  region_cache& operator = (region_cache const&) = delete;
+
+
+  size_type window() const noexcept { return window_; }
+  size_type capacity() const noexcept { return capacity_; }
+  size_type mapped() const noexcept { return mapped_; }
+  std::size_t count() const noexcept { return lru_.size(); }
+
+
+  view get(offset_type offset, size_type size) {
+    if(offset < 0 || size <= 0)
+      return view{};
+    offset_type const start = offset / window_ * window_;
+    size_type const length = round_up(offset + size - start, window_);
+
+    auto found = index_.find(start);
+    if(found != index_.end()) {
+      auto const entry = found->second;
+      if(entry->region->size >= offset + size - start) {
+        lru_.splice(lru_.begin(), lru_, entry);
+        return make_view(*entry, offset, size);
+      }
+      erase(entry);
+    }
+
+    auto const file_size = file_->size();
+    if(!file_size || offset + size > *file_size)
+      return view{};
+    size_type const rest = *file_size - start;
+    auto region = std::make_shared<mapped_file::region>(
+        file_->map(start, length < rest ? length : rest));
+    if(!*region)
+      return view{};
+    lru_.push_front(entry_type{start, std::move(region)});
+    index_.emplace(start, lru_.begin());
+    mapped_ += lru_.front().region->size;
+    view result = make_view(lru_.front(), offset, size);
+    evict();
+    return result;
+  }
+
+
+  void clear() noexcept {
+    lru_.clear();
+    index_.clear();
+    mapped_ = 0;
+  }
+
+private:
+
+  struct entry_type {
+    offset_type start;
+    std::shared_ptr<mapped_file::region> region;
+  };
+
+  using lru_type = std::list<entry_type>;
+
+  mapped_file* file_;
+  size_type window_;
+  size_type capacity_;
+  size_type mapped_{0};
+  lru_type lru_;
+  std::unordered_map<offset_type, lru_type::iterator> index_;
+
+
+  static size_type round_up(size_type n, size_type unit) noexcept {
+    return (n + unit - 1) / unit * unit;
+  }
+
+
+  static view make_view(entry_type const& entry,
+                        offset_type offset, size_type size) noexcept {
+    return view{entry.region, entry.region->address + (offset - entry.start), size};
+  }
+
+
+  void erase(lru_type::iterator entry) noexcept {
+    mapped_ -= entry->region->size;
+    index_.erase(entry->start);
+    lru_.erase(entry);
+  }
+
+
+  void evict() noexcept {
+    while(mapped_ > capacity_ && lru_.size() > 1)
+      erase(std::prev(lru_.end()));
+  }
+
+}; // region_cache
+
+
+} // iofet
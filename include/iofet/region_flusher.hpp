@@ -0,0 +1,123 @@
+/* This file is part of iofet library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "mapped_file.hpp"
+
+
+namespace iofet {
+
+
+// Writes into a mapped region while remembering the pages they touched,
+// so flush() syncs only those pages instead of the whole view.
+class region_flusher {
+public:
+  using size_type = mapped_file::size_type;
+  using offset_type = mapped_file::offset_type;
+  using flush_mode = mapped_file::flush_mode;
+
+  region_flusher() noexcept = default;
+  explicit region_flusher(mapped_file::region& region) noexcept:
+    region_{&region} { }
+
+  explicit operator bool () const noexcept {
+    return region_ != nullptr && !!*region_;
+  }
+
+
+  bool write(offset_type offset, char const* data, size_type n) {
+    if(!*this || offset < 0 || n < 0 || offset + n > region_->size)
+      return false;
+    std::memcpy(region_->address + offset, data, size_t(n));
+    mark_dirty(offset, n);
+    return true;
+  }
+
+
+  template<typename T>
+  bool binary_write(offset_type offset, T const& value) {
+    return write(offset, reinterpret_cast<char const*>(&value), sizeof(T));
+  }
+
+
+  // For writes made directly through region.address
+  void mark_dirty(offset_type offset, size_type n) {
+    // ranges outside the region are ignored, they would be stored inverted
+    if(!*this || n <= 0 || offset < 0 || offset >= region_->size)
+      return;
+    auto const page = mapped_file::page_size();
+    offset_type const first = offset / page * page;
+    offset_type const last = std::min((offset + n + page - 1) / page * page,
+                                      region_->size);
+    // ranges stay sorted and disjoint, so dirty() counts a page once
+    auto it = std::lower_bound(dirty_.begin(), dirty_.end(), first,
+        [](std::pair<offset_type, offset_type> const& range, offset_type value) {
+          return range.second < value;
+        });
+    if(it == dirty_.end() || it->first > last) {
+      dirty_.emplace(it, first, last);
+      return;
+    }
+    it->first = std::min(it->first, first);
+    it->second = std::max(it->second, last);
+    auto next = it + 1;
+    for(; next != dirty_.end() && next->first <= it->second; ++next)
+      it->second = std::max(it->second, next->second);
+    dirty_.erase(it + 1, next);
+  }
+
+
+  size_type dirty() const noexcept {
+    size_type result = 0;
+    for(auto const& range: dirty_)
+      result += range.second - range.first;
+    return result;
+  }
+
+
+  bool flush(flush_mode mode = flush_mode::sync) noexcept {
+    if(!*this)
+      return false;
+    for(auto const& range: dirty_)
+      if(!region_->flush(range.first, range.second - range.first, mode))
+        return false;
+    dirty_.clear();
+    return true;
+  }
+
+private:
+
+  mapped_file::region* region_{nullptr};
+  std::vector<std::pair<offset_type, offset_type>> dirty_;
+
+}; // region_flusher
+
+
+} // iofet
@@ -0,0 +1,122 @@
+/* This file is part of iofet library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+
+namespace iofet {
+
+
+// Snapshot of T published by one writer to any number of readers, possibly
+// in other processes mapping the same memory. Two copies are kept and the
+// writer always fills the one readers are not directed to, so a reader
+// only retries when the writer laps it twice. Readers never write to the
+// slot, so polling does not bounce cache lines between them.
+template<typename T>
+class seqlock_slot {
+public:
+  static_assert(std::is_trivially_copyable_v<T>,
+                "seqlock_slot copies values as raw bytes");
+  static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+                "counters are shared between processes");
+
+  static constexpr std::size_t cache_line = 64;
+
+
+  // Constructs a slot at address, which must be aligned to cache_line
+  static seqlock_slot* create(void* address) noexcept {
+    return new(address) seqlock_slot{};
+  }
+
+
+  // Slot already constructed at address, for instance by another process
+  static seqlock_slot* attach(void* address) noexcept {
+    return std::launder(reinterpret_cast<seqlock_slot*>(address));
+  }
+
+
+  seqlock_slot() noexcept = default;
+  seqlock_slot(seqlock_slot const&) = delete;
+  seqlock_slot& operator = (seqlock_slot const&) = delete;
+
+
+  // Writer side, one writer at a time
+  void store(T const& value) noexcept {
+    auto const version = version_.load(std::memory_order_relaxed);
+    buffer_type& buffer = buffers_[(version + 1) & 1];
+    auto const sequence = buffer.sequence.load(std::memory_order_relaxed);
+    buffer.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&buffer.value, &value, sizeof(T));
+    buffer.sequence.store(sequence + 2, std::memory_order_release);
+    version_.store(version + 1, std::memory_order_release);
+  }
+
+
+  // Single attempt, fails if the writer was overwriting the copy
+  bool try_load(T& value) const noexcept {
+    auto const version = version_.load(std::memory_order_acquire);
+    buffer_type const& buffer = buffers_[version & 1];
+    auto const before = buffer.sequence.load(std::memory_order_acquire);
+    if(before & 1)
+      return false;
+    std::memcpy(&value, &buffer.value, sizeof(T));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return buffer.sequence.load(std::memory_order_relaxed) == before;
+  }
+
+
+  T load() const noexcept {
+    T value;
+    while(!try_load(value))
+      ;
+    return value;
+  }
+
+
+  // Number of stores so far
+  std::uint64_t version() const noexcept {
+    return version_.load(std::memory_order_acquire);
+  }
+
+private:
+
+  struct buffer_type {
+    alignas(cache_line) std::atomic<std::uint64_t> sequence{0};
+    T value;
+  };
+
+  alignas(cache_line) std::atomic<std::uint64_t> version_{0};
+  buffer_type buffers_[2];
+
+}; // seqlock_slot
+
+
+} // iofet
@@ -0,0 +1,194 @@
+/* This file is part of iofet library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+#include <utility>
+
+
+namespace iofet {
+
+  namespace detail {
+
+    struct static_segment {
+      std::size_t offset{0};
+      std::size_t size{0};
+    };
+
+
+    constexpr std::size_t mask_length(char const* mask) noexcept {
+      std::size_t n = 0;
+      while(mask[n] != '\0')
+        ++n;
+      return n;
+    }
+
+
+    constexpr std::size_t segment_count(char const* mask) noexcept {
+      std::size_t n = 0;
+      for(std::size_t i = 0; mask[i] != '\0'; ++i)
+        if(mask[i] != '*' && (i == 0 || mask[i - 1] == '*'))
+          ++n;
+      return n;
+    }
+
+
+    template<std::size_t N>
+    constexpr std::array<static_segment, N> segments_of(char const* mask) noexcept {
+      std::array<static_segment, N> result{};
+      std::size_t n = 0;
+      for(std::size_t i = 0; mask[i] != '\0'; ++i) {
+        if(mask[i] == '*')
+          continue;
+        if(i == 0 || mask[i - 1] == '*')
+          result[n++].offset = i;
+        ++result[n - 1].size;
+      }
+      return result;
+    }
+
+
+    constexpr bool has(char const* mask, char c) noexcept {
+      for(std::size_t i = 0; mask[i] != '\0'; ++i)
+        if(mask[i] == c)
+          return true;
+      return false;
+    }
+
+  } // detail
+
+
+  // Mask known at build time, for instance
+  //
+  //   static constexpr char log_mask[] = "*.log";
+  //   iofet::static_glob<log_mask>::matches(name);
+  //
+  // The mask is split into '*' separated segments during compilation and
+  // every segment is matched by an unrolled sequence of character compares,
+  // '?' positions being dropped altogether. The mask should be ASCII when
+  // matching wide names.
+  template<char const* Mask>
+  class static_glob {
+  public:
+
+    template<typename C>
+    static bool matches(std::basic_string_view<C> text) noexcept {
+      C const* const data = text.data();
+      std::size_t const n = text.size();
+      if constexpr(!star)
+        return n == size && equal<0>(data, std::make_index_sequence<size>{});
+      else
+        return matches_segments(data, n,
+                                std::make_index_sequence<last - first>{});
+    }
+
+
+    template<typename C>
+    static bool matches(C const* text) noexcept {
+      return matches(std::basic_string_view<C>{text});
+    }
+
+
+    template<typename C>
+    bool operator () (std::basic_string_view<C> text) const noexcept {
+      return matches(text);
+    }
+
+  private:
+
+    static constexpr std::size_t size = detail::mask_length(Mask);
+    static constexpr std::size_t count = detail::segment_count(Mask);
+    static constexpr std::array<detail::static_segment, count> segments =
+        detail::segments_of<count>(Mask);
+    static constexpr bool star = detail::has(Mask, '*');
+    static constexpr bool anchored_front = size != 0 && Mask[0] != '*';
+    static constexpr bool anchored_back = size != 0 && Mask[size - 1] != '*';
+    // segments placed at the ends are not searched for
+    static constexpr std::size_t first = anchored_front ? 1 : 0;
+    static constexpr std::size_t last = anchored_back && count > first ? count - 1 : count;
+
+    static constexpr std::size_t min_size() noexcept {
+      std::size_t result = 0;
+      for(auto const& segment: segments)
+        result += segment.size;
+      return result;
+    }
+
+
+    template<std::size_t Offset, typename C, std::size_t... I>
+    static bool equal([[maybe_unused]] C const* text, std::index_sequence<I...>) noexcept {
+      return ((Mask[Offset + I] == '?' || text[I] == C(Mask[Offset + I])) && ...);
+    }
+
+
+    template<std::size_t S, typename C>
+    static bool equal_segment(C const* text) noexcept {
+      return equal<segments[S].offset>(
+          text, std::make_index_sequence<segments[S].size>{});
+    }
+
+
+    // Leftmost placement of segment S in [from, to)
+    template<std::size_t S, typename C>
+    static bool place(C const* text, std::size_t& from, std::size_t to) noexcept {
+      constexpr std::size_t length = segments[S].size;
+      for(std::size_t position = from; position + length <= to; ++position)
+        if(equal_segment<S>(text + position)) {
+          from = position + length;
+          return true;
+        }
+      return false;
+    }
+
+
+    template<typename C, std::size_t... S>
+    static bool matches_segments(C const* text, std::size_t n,
+                                 std::index_sequence<S...>) noexcept {
+      if(n < min_size())
+        return false;
+      std::size_t from = 0;
+      std::size_t to = n;
+      if constexpr(anchored_front) {
+        if(!equal_segment<0>(text))
+          return false;
+        from = segments[0].size;
+      }
+      if constexpr(anchored_back && count > first) {
+        constexpr std::size_t length = segments[count - 1].size;
+        if(!equal_segment<count - 1>(text + n - length))
+          return false;
+        to = n - length;
+      }
+      if(from > to)
+        return false;
+      return (place<first + S>(text, from, to) && ...);
+    }
+
+  }; // static_glob
+
+
+} // iofet
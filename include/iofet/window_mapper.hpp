@@ -0,0 +1,204 @@
+/* This file is part of iofet library
+ * Copyright 2020 Andrei Ilin <ortfero@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#pragma once
+
+
+#include <filesystem>
+
+#include "mapped_file.hpp"
+
+
+#ifdef _WIN32
+
+#if !defined(_X86_) && !defined(_AMD64_) && !defined(_ARM_) && !defined(_ARM64_)
+#if defined(_M_IX86)
+#define _X86_
+#elif defined(_M_AMD64)
+#define _AMD64_
+#elif defined(_M_ARM)
+#define _ARM_
+#elif defined(_M_ARM64)
+#define _ARM64_
+#endif
+#endif
+
+#include <minwindef.h>
+#include <memoryapi.h>
+#include <processthreadsapi.h>
+
+#else
+
+#include <sys/mman.h>
+
+#endif // WIN32
+
+
+namespace iofet {
+
+
+// Cursor over a file that keeps at most two fixed-size windows mapped:
+// the one being consumed and the next one, whose pages are read ahead
+// by the kernel while the current one is processed.
+class window_mapper {
+public:
+  using size_type = mapped_file::size_type;
+  using offset_type = mapped_file::offset_type;
+
+  static constexpr size_type default_window = 16 * 1024 * 1024;
+
+
+  static window_mapper open(std::filesystem::path const& path,
+                            size_type window = default_window) noexcept {
+    window_mapper result;
+    if(window <= 0)
+      return result;
+    // read only, so archives without write permission can be walked too
+    result.file_ = mapped_file::open_to_read(path.string());
+    if(!result.file_)
+      return result;
+    auto const size = result.file_.size();
+    if(!size)
+      return result;
+    auto const granularity = mapped_file::granularity();
+    result.size_ = *size;
+    result.window_ = (window + granularity - 1) / granularity * granularity;
+    result.opened_ = true;
+    if(!result.seek(0))
+      result.opened_ = false;
+    return result;
+  }
+
+
+  static std::error_code last_error() noexcept {
+    return mapped_file::last_error();
+  }
+
+
+  window_mapper() noexcept = default;
+  window_mapper(window_mapper const&) = delete;
+  window_mapper& operator = (window_mapper const&) = delete;
+  window_mapper(window_mapper&&) noexcept = default;
+  window_mapper& operator = (window_mapper&&) noexcept = default;
+
+
+  explicit operator bool () const noexcept { return opened_; }
+  size_type size() const noexcept { return size_; }
+  size_type window() const noexcept { return window_; }
+  offset_type position() const noexcept { return position_; }
+  bool eof() const noexcept { return position_ >= size_; }
+
+
+  // Pointer to the byte at position(), valid until the cursor leaves its window
+  char const* data() const noexcept {
+    if(!current_)
+      return nullptr;
+    return current_.address + (position_ - current_offset_);
+  }
+
+
+  // Bytes available contiguously from position() to the end of its window
+  size_type available() const noexcept {
+    if(!current_)
+      return 0;
+    return current_.size - (position_ - current_offset_);
+  }
+
+
+  // On failure the cursor stays where it was
+  bool seek(offset_type offset) noexcept {
+    if(!opened_ || offset < 0 || offset > size_)
+      return false;
+    if(offset == size_) {
+      current_ = mapped_file::region{};
+      next_ = mapped_file::region{};
+      position_ = offset;
+      return true;
+    }
+    offset_type const start = offset / window_ * window_;
+    if(current_ && start == current_offset_) {
+      position_ = offset;
+      return true;
+    }
+    if(next_ && start == current_offset_ + window_) {
+      current_ = std::move(next_);
+    } else {
+      auto mapped = map_window(start);
+      if(!mapped)
+        return false;
+      current_ = std::move(mapped);
+    }
+    current_offset_ = start;
+    position_ = offset;
+    next_ = map_window(start + window_);
+    if(next_)
+      prefetch(next_);
+    return true;
+  }
+
+
+  bool advance(size_type n) noexcept {
+    return seek(position_ + n);
+  }
+
+private:
+
+  mapped_file file_;
+  mapped_file::region current_;
+  mapped_file::region next_;
+  offset_type current_offset_{0};
+  offset_type position_{0};
+  size_type size_{0};
+  size_type window_{default_window};
+  bool opened_{false};
+
+
+  mapped_file::region map_window(offset_type start) noexcept {
+    if(start >= size_)
+      return mapped_file::region{};
+    size_type const rest = size_ - start;
+    return file_.map(start, rest < window_ ? rest : window_);
+  }
+
+
+#ifdef _WIN32
+
+  static void prefetch(mapped_file::region const& region) noexcept {
+    WIN32_MEMORY_RANGE_ENTRY entry;
+    entry.VirtualAddress = region.address;
+    entry.NumberOfBytes = SIZE_T(region.size);
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &entry, 0);
+  }
+
+#else
+
+  static void prefetch(mapped_file::region const& region) noexcept {
+    ::madvise(region.address, size_t(region.size), MADV_WILLNEED);
+  }
+
+#endif // _WIN32
+
+}; // window_mapper
+
+
+} // iofet
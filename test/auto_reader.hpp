@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string.h>
+#include <vector>
+#include <doctest/doctest.h>
+
+#include <iofet/auto_reader.hpp>
+
+
+TEST_CASE("auto_reader::choose") {
+  using iofet::auto_reader;
+  auto const small = auto_reader::choose(100, auto_reader::access::random, 0.);
+  REQUIRE(small.chosen == auto_reader::method::buffered);
+  auto const random = auto_reader::choose(1 << 20, auto_reader::access::random, {});
+  REQUIRE(random.chosen == auto_reader::method::mapped);
+  REQUIRE(random.cached < 0.);
+  auto const cold = auto_reader::choose(1 << 20, auto_reader::access::sequential, 0.1);
+  REQUIRE(cold.chosen == auto_reader::method::buffered);
+  auto const hot = auto_reader::choose(1 << 20, auto_reader::access::sequential, 0.9);
+  REQUIRE(hot.chosen == auto_reader::method::mapped);
+}
+
+
+TEST_CASE("auto_reader::open") {
+  using namespace iofet;
+  {
+    auto f = file::create("test.auto");
+    std::vector<char> content(256 * 1024, 'a');
+    memcpy(content.data() + 200000, "hello", 5);
+    f.write(content.data(), auto_reader::size_type(content.size()));
+  }
+  int hooked = 0;
+  auto_reader::decision logged{};
+  auto const hook = [&](std::filesystem::path const&, auto_reader::decision const& d) {
+    ++hooked;
+    logged = d;
+  };
+  for(auto pattern: {auto_reader::access::random, auto_reader::access::sequential}) {
+    auto target = auto_reader::open("test.auto", pattern, hook);
+    REQUIRE(target);
+    REQUIRE(target.size() == 256 * 1024);
+    REQUIRE(logged.chosen == target.choice().chosen);
+    REQUIRE((target.data() != nullptr) == (logged.chosen == auto_reader::method::mapped));
+    char buffer[5];
+    REQUIRE(target.read(200000, buffer, 5));
+    REQUIRE(memcmp(buffer, "hello", 5) == 0);
+    REQUIRE(!target.read(256 * 1024 - 1, buffer, 5));
+  }
+  REQUIRE(hooked == 2);
+  file::remove("test.auto");
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <doctest/doctest.h>
+
+#include <iofet/dir_snapshot.hpp>
+#include <iofet/file.hpp>
+
+
+namespace dir_snapshot_test {
+
+  std::vector<std::string> strings(std::vector<iofet::dir_snapshot::string_type> const& names) {
+    std::vector<std::string> result;
+    for(auto const& name: names)
+      result.push_back(std::filesystem::path{name}.string());
+    return result;
+  }
+
+}
+
+
+TEST_CASE("dir_snapshot::diff") {
+  namespace fs = std::filesystem;
+  using namespace dir_snapshot_test;
+  fs::path const root{"snapshot.test"};
+  fs::create_directories(root);
+  iofet::file::touch(root / "a.log");
+  iofet::file::touch(root / "b.log");
+  iofet::file::touch(root / "c.idx");
+
+  auto const before = iofet::dir_snapshot::take(root, "*.log");
+  REQUIRE(before);
+  REQUIRE(before->size() == 2);
+  REQUIRE((*before)[0].name == iofet::dir_snapshot::name_type{fs::path{"a.log"}.native()});
+
+  iofet::file::remove(root / "a.log");
+  iofet::file::touch(root / "d.log");
+  {
+    auto f = iofet::file::open_to_append(root / "b.log");
+    REQUIRE(f.write("x", 1));
+  }
+  auto const after = iofet::dir_snapshot::take(root, "*.log");
+  REQUIRE(after);
+  auto const changes = iofet::diff(*before, *after);
+  REQUIRE(strings(changes.added) == std::vector<std::string>{"d.log"});
+  REQUIRE(strings(changes.removed) == std::vector<std::string>{"a.log"});
+  REQUIRE(strings(changes.modified) == std::vector<std::string>{"b.log"});
+  REQUIRE(iofet::diff(*after, *after).empty());
+
+  REQUIRE(!iofet::dir_snapshot::take(root / "missing"));
+  fs::remove_all(root);
+}
+
+
+TEST_CASE("dir_snapshot::refresh") {
+  namespace fs = std::filesystem;
+  fs::path const root{"refresh.test"};
+  fs::create_directories(root);
+  iofet::file::touch(root / "a.log");
+  // old enough for the listing to be trusted
+  fs::last_write_time(root, fs::last_write_time(root) - std::chrono::hours{1});
+
+  auto const first = iofet::dir_snapshot::take(root);
+  REQUIRE(first);
+  auto const same = iofet::dir_snapshot::refresh(*first);
+  REQUIRE(same);
+  REQUIRE(same->shares(*first));
+  REQUIRE(iofet::diff(*first, *same).empty());
+
+  iofet::file::touch(root / "b.log");
+  auto const changed = iofet::dir_snapshot::refresh(*first);
+  REQUIRE(changed);
+  REQUIRE(!changed->shares(*first));
+  REQUIRE(iofet::diff(*first, *changed).added.size() == 1);
+
+  // a directory modified just now is always read again
+  auto const recent = iofet::dir_snapshot::refresh(*changed);
+  REQUIRE(recent);
+  REQUIRE(!recent->shares(*changed));
+  fs::remove_all(root);
+}
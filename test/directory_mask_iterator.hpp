@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <vector>
 #include <doctest/doctest.h>
 
 #include <iofet/directory_mask_iterator.hpp>
@@ -28,13 +30,18 @@ TEST_CASE("directory_mask_iterator::increment") {
   file::touch("b.1");
   std::error_code ec;
   directory_mask_iterator it{ ".", "*.1", ec};
+  // directory order is unspecified outside of NTFS
+  std::vector<std::filesystem::path> names;
   REQUIRE(it != end(it));
-  REQUIRE(it->path().filename() == "a.1");
+  names.push_back(it->path().filename());
   ++it;
   REQUIRE(it != end(it));
-  REQUIRE(it->path().filename() == "b.1");
+  names.push_back(it->path().filename());
   ++it;
   REQUIRE(it == end(it));
+  std::sort(names.begin(), names.end());
+  REQUIRE(names[0] == "a.1");
+  REQUIRE(names[1] == "b.1");
   file::remove("a.1");
   file::remove("b.1");
   file::remove("c.2");
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <doctest/doctest.h>
+
+#include <iofet/directory_reader.hpp>
+#include <iofet/file.hpp>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif // _WIN32
+
+
+TEST_CASE("directory_reader") {
+  namespace fs = std::filesystem;
+  using iofet::directory_reader;
+  fs::path const root{"reader.test"};
+  fs::create_directories(root / "sub");
+  for(int i = 0; i != 300; ++i)
+    iofet::file::touch(root / ("file_" + std::to_string(i)));
+
+  // a small buffer takes several refills
+  auto reader = directory_reader::open(root, 4096);
+  REQUIRE(!!reader);
+  std::map<std::string, directory_reader::entry_type> found;
+  directory_reader::entry e;
+  while(reader.next(e)) {
+    fs::path const name{fs::path::string_type{e.name}};
+    found[name.string()] = reader.type_of(e);
+#ifndef _WIN32
+    struct stat st;
+    REQUIRE(::stat((root / name).c_str(), &st) == 0);
+    REQUIRE(e.inode == std::uint64_t(st.st_ino));
+#endif // _WIN32
+  }
+  REQUIRE(!directory_reader::last_error());
+  REQUIRE(found.size() == 301);
+  REQUIRE(found["sub"] == directory_reader::entry_type::directory);
+  REQUIRE(found["file_299"] == directory_reader::entry_type::regular);
+  REQUIRE(!reader.next(e));
+
+  // batches never span two kernel buffers
+  auto batched = directory_reader::open(root, 4096);
+  directory_reader::entry batch[64];
+  std::size_t total = 0;
+  std::size_t batches = 0;
+  while(std::size_t const n = batched.next_batch(batch)) {
+    REQUIRE(n <= 64);
+    for(std::size_t i = 0; i != n; ++i)
+      REQUIRE(found.count(fs::path{fs::path::string_type{batch[i].name}}.string()) == 1);
+    total += n;
+    ++batches;
+  }
+  REQUIRE(total == 301);
+  REQUIRE(batches > 301 / 64);
+
+  REQUIRE(!directory_reader::open(root / "missing"));
+  fs::remove_all(root);
+}
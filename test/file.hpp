@@ -2,6 +2,8 @@
 
 #include <string.h>
 #include <filesystem>
+#include <memory_resource>
+#include <vector>
 #include <doctest/doctest.h>
 
 #include <iofet/file.hpp>
@@ -50,3 +52,61 @@ TEST_CASE("file::resize") {
   REQUIRE(target.resize(0));
   REQUIRE(std::filesystem::file_size("test.file") == 0);
 }
+
+
+TEST_CASE("file::cached_fraction") {
+  std::vector<char> const content(4 * 4096, 'x');
+  {
+    auto target = iofet::file::create("cached.file");
+    REQUIRE(target.write(content.data(), iofet::file::size_type(content.size())));
+  }
+  auto target = iofet::file::open_to_read("cached.file");
+  std::vector<char> buffer(content.size());
+  // just read, so at least some of its pages are in the page cache
+  REQUIRE(target.read(buffer.data(), iofet::file::size_type(buffer.size())));
+  auto const cached = target.cached_fraction();
+#ifdef _WIN32
+  REQUIRE(!cached);
+#else
+  REQUIRE(cached);
+  REQUIRE(*cached > 0.);
+  REQUIRE(*cached <= 1.);
+#endif
+  target.close();
+  iofet::file::remove("cached.file");
+}
+
+
+TEST_CASE("file::read_all") {
+  {
+    auto target = iofet::file::create("test.file");
+    REQUIRE(target.write("hello world", 11));
+  }
+  auto const contents = iofet::file::read_all("test.file");
+  REQUIRE(contents);
+  REQUIRE(contents->size == 11);
+  REQUIRE(memcmp(contents->data.get(), "hello world", 11) == 0);
+  
+  std::pmr::monotonic_buffer_resource resource;
+  auto const text = iofet::file::read_all("test.file",
+                                          std::pmr::polymorphic_allocator<char>{&resource});
+  REQUIRE(text);
+  REQUIRE(*text == "hello world");
+  REQUIRE(text->get_allocator().resource() == &resource);
+  
+  REQUIRE(!iofet::file::read_all("missing.file"));
+}
+
+
+#ifndef _WIN32
+TEST_CASE("file::read_all/pseudo") {
+  // procfs reports a size of 0
+  auto const contents = iofet::file::read_all("/proc/self/status");
+  REQUIRE(contents);
+  REQUIRE(contents->size > 0);
+  REQUIRE(memcmp(contents->data.get(), "Name:", 5) == 0);
+  auto const text = iofet::file::read_all("/proc/self/maps", std::allocator<char>{});
+  REQUIRE(text);
+  REQUIRE(text->size() > 0);
+}
+#endif
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <doctest/doctest.h>
+
+#include <iofet/glob.hpp>
+#include <iofet/directory_mask_iterator.hpp>
+
+
+TEST_CASE("glob::classification") {
+  using glob = iofet::basic_glob<char>;
+  REQUIRE(glob{"a.log"}.classification() == glob::kind::exact);
+  REQUIRE(glob{"trade_2024*"}.classification() == glob::kind::prefix);
+  REQUIRE(glob{"*"}.classification() == glob::kind::prefix);
+  REQUIRE(glob{"*.log"}.classification() == glob::kind::suffix);
+  REQUIRE(glob{"**.log"}.classification() == glob::kind::suffix);
+  REQUIRE(glob{"*2024*"}.classification() == glob::kind::contains);
+  REQUIRE(glob{"trade_*.log"}.classification() == glob::kind::general);
+  REQUIRE(glob{"a?.log"}.classification() == glob::kind::general);
+}
+
+
+TEST_CASE("glob::matches") {
+  using glob = iofet::basic_glob<char>;
+  REQUIRE(glob{"*.log"}.matches("a.log"));
+  REQUIRE(!glob{"*.log"}.matches("a.log1"));
+  REQUIRE(glob{"trade_*.log"}.matches("trade_2024.log"));
+  REQUIRE(!glob{"trade_*.log"}.matches("trade.log"));
+  REQUIRE(glob{"*a*b?c*"}.matches("xxaxxbxcxx"));
+  REQUIRE(!glob{"*a*b?c*"}.matches("xxaxxbcxx"));
+  REQUIRE(glob{""}.matches(""));
+  REQUIRE(!glob{""}.matches("a"));
+}
+
+
+TEST_CASE("glob::matches/detail::matched") {
+  // every mask over {a, b, *, ?} up to 5 characters against every name
+  // over {a, b} up to 6 characters
+  auto const expand = [](std::string const& alphabet, std::size_t length) {
+    std::vector<std::string> result{""};
+    for(std::size_t i = 0; i != result.size(); ++i)
+      if(result[i].size() < length)
+        for(char c: alphabet)
+          result.push_back(result[i] + c);
+    return result;
+  };
+  auto const masks = expand("ab*?", 5);
+  auto const names = expand("ab", 6);
+  int mismatches = 0;
+  for(auto const& mask: masks) {
+    iofet::basic_glob<char> const compiled{mask};
+    for(auto const& name: names)
+      if(compiled.matches(name) != iofet::detail::matched(mask.data(), name.data()))
+        ++mismatches;
+  }
+  REQUIRE(mismatches == 0);
+}
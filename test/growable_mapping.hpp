@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string.h>
+#include <filesystem>
+#include <doctest/doctest.h>
+
+#include <iofet/growable_mapping.hpp>
+
+
+TEST_CASE("growable_mapping::growable_mapping") {
+  iofet::growable_mapping target;
+  REQUIRE(!target);
+}
+
+
+TEST_CASE("growable_mapping::open") {
+  using namespace iofet;
+  file::create("test.file");
+  auto target = growable_mapping::open("test.file", 16 * mapped_file::granularity(),
+                                       mapped_file::granularity());
+  REQUIRE(target);
+  REQUIRE(target.size() == 0);
+  REQUIRE(target.capacity() == 16 * mapped_file::granularity());
+}
+
+
+TEST_CASE("growable_mapping::append") {
+  using namespace iofet;
+  file::create("test.file");
+  auto const step = mapped_file::granularity();
+  auto target = growable_mapping::open("test.file", 16 * step, step);
+  REQUIRE(target);
+  char* const base = target.data();
+  REQUIRE(target.append("hello", 5));
+  char* const tail = target.append(2 * step);
+  REQUIRE(tail == base + 5);
+  memset(tail, 'x', size_t(2 * step));
+  REQUIRE(target.append(" world", 6));
+  REQUIRE(target.data() == base);
+  REQUIRE(target.committed() == 3 * step);
+  REQUIRE(!target.append(16 * step));
+  target.close();
+  REQUIRE(std::filesystem::file_size("test.file") == 2 * step + 11);
+  
+  target = growable_mapping::open("test.file", 16 * step, step);
+  REQUIRE(target.size() == 2 * step + 11);
+  REQUIRE(memcmp(target.data(), "hello", 5) == 0);
+  REQUIRE(memcmp(target.data() + 2 * step + 5, " world", 6) == 0);
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <memory_resource>
+#include <vector>
+#include <doctest/doctest.h>
+
+#include <iofet/file.hpp>
+#include <iofet/mapped_arena.hpp>
+
+
+namespace {
+
+  struct arena_node {
+    int value;
+    iofet::offset_ptr<arena_node> next;
+  };
+
+}
+
+
+TEST_CASE("offset_ptr::offset_ptr") {
+  using iofet::offset_ptr;
+  offset_ptr<int> empty;
+  REQUIRE(!empty);
+  REQUIRE(empty.get() == nullptr);
+  int values[2] = {1, 2};
+  offset_ptr<int> target = &values[1];
+  REQUIRE(*target == 2);
+  offset_ptr<int> copy = target;
+  REQUIRE(copy == target);
+  REQUIRE(copy.get() == &values[1]);
+}
+
+
+TEST_CASE("mapped_arena::create") {
+  using namespace iofet;
+  auto const size = 16 * mapped_file::granularity();
+  auto f = file::create("test.arena");
+  f.resize(size);
+  f.close();
+  auto mapped = mapped_file::open("test.arena");
+  auto region = mapped.map();
+  auto arena = mapped_arena::create(region);
+  REQUIRE(arena);
+  REQUIRE(arena.capacity() == size);
+  REQUIRE(arena.root<arena_node>() == nullptr);
+  
+  arena_node* head = nullptr;
+  for(int i = 0; i != 100; ++i)
+    head = arena.construct<arena_node>(arena_node{i, head});
+  arena.set_root(head);
+  
+  void* const block = arena.allocate(100);
+  arena.deallocate(block, 100);
+  REQUIRE(arena.allocate(120) == block);
+  REQUIRE(arena.allocate(size) == nullptr);
+  REQUIRE(arena.allocate(8, 128) == nullptr);
+}
+
+
+TEST_CASE("mapped_arena::open") {
+  using namespace iofet;
+  auto mapped = mapped_file::open("test.arena");
+  // keep the old address busy so the region lands elsewhere
+  auto placeholder = mapped.map();
+  auto region = mapped.map();
+  auto arena = mapped_arena::open(region);
+  REQUIRE(arena);
+  int expected = 99;
+  for(auto* node = arena.root<arena_node>(); node != nullptr; node = node->next.get())
+    REQUIRE(node->value == expected--);
+  REQUIRE(expected == -1);
+}
+
+
+TEST_CASE("mapped_arena_resource") {
+  using namespace iofet;
+  auto mapped = mapped_file::open("test.arena");
+  auto region = mapped.map();
+  auto arena = mapped_arena::create(region);
+  mapped_arena_resource resource{arena};
+  std::pmr::vector<int> values{&resource};
+  for(int i = 0; i != 1000; ++i)
+    values.push_back(i);
+  auto const data = reinterpret_cast<char const*>(values.data());
+  REQUIRE(data > region.address);
+  REQUIRE(data < region.address + region.size);
+  REQUIRE_THROWS_AS(values.reserve(size_t(region.size)), std::bad_alloc);
+  values = std::pmr::vector<int>{&resource};
+  region = mapped_file::region{};
+  mapped = mapped_file{};
+  file::remove("test.arena");
+}
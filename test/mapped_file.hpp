@@ -40,3 +40,86 @@ TEST_CASE("mapped_file::map/2") {
   auto region2 = target.map(mapped_file::granularity(), mapped_file::granularity());
   REQUIRE(region2);
 }
+
+
+TEST_CASE("mapped_file::region::flush") {
+  using iofet::mapped_file;
+  auto target = mapped_file::open("test.file");
+  auto region = target.map(0, mapped_file::granularity());
+  REQUIRE(region);
+  region.address[0] = 'x';
+  REQUIRE(region.flush());
+  REQUIRE(region.flush(1, 100, mapped_file::flush_mode::async));
+  REQUIRE(!region.flush(1, mapped_file::granularity()));
+}
+
+
+TEST_CASE("mapped_file::map/unaligned") {
+  using iofet::mapped_file;
+  REQUIRE(mapped_file::granularity() >= mapped_file::page_size());
+  REQUIRE(mapped_file::granularity() % mapped_file::page_size() == 0);
+  auto target = mapped_file::open("test.file");
+  auto whole = target.map(0, 2 * mapped_file::granularity());
+  REQUIRE(whole);
+  whole.address[mapped_file::granularity() + 3] = 'z';
+  auto region = target.map(mapped_file::granularity() + 3, 10);
+  REQUIRE(region);
+  REQUIRE(region.size == 10);
+  REQUIRE(region.address[0] == 'z');
+  REQUIRE(region.flush());
+}
+
+
+TEST_CASE("mapped_file::open_shared_memory") {
+  using iofet::mapped_file;
+  auto const size = mapped_file::granularity();
+  auto writer = mapped_file::open_shared_memory("iofet.test", size);
+  REQUIRE(writer);
+  REQUIRE(*writer.size() == size);
+  auto reader = mapped_file::open_shared_memory("iofet.test", size);
+  REQUIRE(reader);
+  auto written = writer.map();
+  auto read = reader.map(0, size);
+  REQUIRE(written);
+  REQUIRE(read);
+  written.address[size - 1] = 'x';
+  REQUIRE(read.address[size - 1] == 'x');
+  REQUIRE(mapped_file::remove_shared_memory("iofet.test"));
+}
+
+
+TEST_CASE("mapped_file::anonymous") {
+  using iofet::mapped_file;
+  auto target = mapped_file::anonymous(2 * mapped_file::granularity());
+  REQUIRE(target);
+  auto region = target.map(mapped_file::granularity() + 1, 5);
+  REQUIRE(region);
+  region.address[0] = 'y';
+  REQUIRE(region.flush());
+  auto another = target.map();
+  REQUIRE(another.size == 2 * mapped_file::granularity());
+  REQUIRE(another.address[mapped_file::granularity() + 1] == 'y');
+}
+
+
+TEST_CASE("mapped_file::open_to_read") {
+  using iofet::mapped_file;
+  auto target = mapped_file::open_to_read("test.file");
+  REQUIRE(target);
+  REQUIRE(target.read_only());
+  auto region = target.map(mapped_file::granularity() + 3, 1);
+  REQUIRE(region);
+  REQUIRE(region.address[0] == 'z');
+}
+
+
+TEST_CASE("mapped_file::region::resident_pages") {
+  using iofet::mapped_file;
+  auto target = mapped_file::open("test.file");
+  auto region = target.map(0, 2 * mapped_file::granularity());
+  region.address[0] = 'r';
+  auto const resident = region.resident_pages();
+  REQUIRE(resident);
+  REQUIRE(*resident >= 1);
+  REQUIRE(*resident <= 2 * mapped_file::granularity() / mapped_file::page_size());
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <string.h>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include <doctest/doctest.h>
+
+#include <iofet/mapped_queue.hpp>
+
+
+TEST_CASE("mapped_queue::mapped_queue") {
+  iofet::mapped_queue target;
+  REQUIRE(!target);
+  REQUIRE(target.message_size() == 0);
+  REQUIRE(target.size() == 0);
+  REQUIRE(!target.try_push("", 0));
+  char buffer[16];
+  REQUIRE(!target.try_pop(buffer));
+  REQUIRE(!target.pop(buffer, std::chrono::milliseconds{1}));
+}
+
+
+TEST_CASE("mapped_queue::try_push") {
+  using namespace iofet;
+  auto target = mapped_queue::create("test.queue", 16, 4);
+  REQUIRE(target);
+  REQUIRE(target.message_size() == 16);
+  REQUIRE(target.try_push("hello", 5));
+  REQUIRE(target.try_push("world", 5));
+  REQUIRE(target.try_push("a", 1));
+  REQUIRE(target.try_push("b", 1));
+  REQUIRE(!target.try_push("c", 1));
+  REQUIRE(!target.try_push("0123456789abcdefg", 17));
+  REQUIRE(target.size() == 4);
+}
+
+
+TEST_CASE("mapped_queue::open") {
+  using namespace iofet;
+  char buffer[16];
+  {
+    auto consumer = mapped_queue::open("test.queue");
+    REQUIRE(consumer);
+    auto const n = consumer.try_pop(buffer);
+    REQUIRE(n);
+    REQUIRE(*n == 5);
+    REQUIRE(memcmp(buffer, "hello", 5) == 0);
+  }
+  // restarted consumer resumes from the stored position
+  auto consumer = mapped_queue::open("test.queue");
+  REQUIRE(consumer.size() == 3);
+  auto const n = consumer.try_pop(buffer);
+  REQUIRE(n);
+  REQUIRE(memcmp(buffer, "world", 5) == 0);
+  REQUIRE(consumer.try_push("c", 1));
+}
+
+
+TEST_CASE("mapped_queue::open after interrupted consume") {
+  using namespace iofet;
+  char buffer[16];
+  {
+    auto queue = mapped_queue::create("test.queue", 16, 4);
+    REQUIRE(queue.try_push("first", 5));
+    REQUIRE(queue.try_push("second", 6));
+    REQUIRE(queue.try_pop(buffer));
+  }
+  {
+    // the slot of "first" is released but head is put back on it, as if
+    // the consumer had stopped before storing head; head is the counter on
+    // the third cache line of the header
+    auto f = mapped_file::open("test.queue");
+    auto region = f.map();
+    REQUIRE(region);
+    std::uint64_t head;
+    memcpy(&head, region.address + 2 * mapped_queue::cache_line, sizeof(head));
+    REQUIRE(head == 1);
+    head = 0;
+    memcpy(region.address + 2 * mapped_queue::cache_line, &head, sizeof(head));
+  }
+  auto consumer = mapped_queue::open("test.queue");
+  REQUIRE(consumer.size() == 1);
+  auto const n = consumer.try_pop(buffer);
+  REQUIRE(n);
+  REQUIRE(*n == 6);
+  REQUIRE(memcmp(buffer, "second", 6) == 0);
+}
+
+
+TEST_CASE("mapped_queue::pop") {
+  using namespace iofet;
+  auto consumer = mapped_queue::create("test.queue", 8, 64);
+  constexpr int producers = 4;
+  constexpr int messages = 1000;
+  std::vector<std::thread> threads;
+  for(int p = 0; p != producers; ++p)
+    threads.emplace_back([p] {
+      auto producer = mapped_queue::open("test.queue");
+      for(int i = 0; i != messages; ++i) {
+        int const message[2] = {p, i};
+        while(!producer.try_push(reinterpret_cast<char const*>(message),
+                                 sizeof(message)))
+          std::this_thread::yield();
+      }
+    });
+  int last[producers] = {-1, -1, -1, -1};
+  bool ordered = true;
+  for(int received = 0; received != producers * messages; ++received) {
+    int message[2];
+    auto const n = consumer.pop(reinterpret_cast<char*>(message),
+                                std::chrono::milliseconds{5000});
+    REQUIRE(n);
+    ordered = ordered && message[1] == last[message[0]] + 1;
+    last[message[0]] = message[1];
+  }
+  for(auto& thread: threads)
+    thread.join();
+  REQUIRE(ordered);
+  char buffer[8];
+  REQUIRE(!consumer.pop(buffer, std::chrono::milliseconds{1}));
+  consumer = mapped_queue{};
+  file::remove("test.queue");
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <filesystem>
+#include <doctest/doctest.h>
+
+#include <iofet/file.hpp>
+#include <iofet/mapped_vector.hpp>
+
+
+namespace {
+
+  struct vector_record {
+    long long id;
+    double price;
+  };
+
+}
+
+
+TEST_CASE("mapped_vector::mapped_vector") {
+  iofet::mapped_vector<vector_record> target;
+  REQUIRE(!target);
+  REQUIRE(target.empty());
+}
+
+
+TEST_CASE("mapped_vector::push_back") {
+  using namespace iofet;
+  file::create("test.vector");
+  auto target = mapped_vector<vector_record>::open("test.vector");
+  REQUIRE(target);
+  REQUIRE(target.empty());
+  for(long long i = 0; i != 10000; ++i)
+    REQUIRE(target.push_back(vector_record{i, i * 0.5}));
+  REQUIRE(target.size() == 10000);
+  REQUIRE(target.capacity() >= 10000);
+  REQUIRE(target[9999].id == 9999);
+  
+  vector_record const bulk[3] = {{-1, 1.}, {-2, 2.}, {-3, 3.}};
+  REQUIRE(target.append(bulk, 3));
+  REQUIRE(target.back().id == -3);
+  target.close();
+  REQUIRE(std::filesystem::file_size("test.vector") == 10003 * sizeof(vector_record));
+}
+
+
+TEST_CASE("mapped_vector::open") {
+  using namespace iofet;
+  auto target = mapped_vector<vector_record>::open("test.vector");
+  REQUIRE(target.size() == 10003);
+  long long sum = 0;
+  for(auto const& record: target)
+    sum += record.id;
+  REQUIRE(sum == 9999ll * 10000 / 2 - 6);
+  REQUIRE(target.resize(10, vector_record{7, 7.}));
+  REQUIRE(target.resize(12, vector_record{7, 7.}));
+  REQUIRE(target[11].id == 7);
+  target.close();
+  REQUIRE(std::filesystem::file_size("test.vector") == 12 * sizeof(vector_record));
+  file::remove("test.vector");
+}
+
+
+TEST_CASE("mapped_vector::reserve failure") {
+  using namespace iofet;
+  file::create("test.vector");
+  auto target = mapped_vector<vector_record>::open("test.vector");
+  REQUIRE(target.push_back(vector_record{1, 1.}));
+  auto const capacity = target.capacity();
+  REQUIRE(!target.reserve(1ll << 58));
+  REQUIRE(target);
+  REQUIRE(target.size() == 1);
+  REQUIRE(target.capacity() == capacity);
+  REQUIRE(target[0].id == 1);
+  REQUIRE(target.push_back(vector_record{2, 2.}));
+  REQUIRE(target.back().id == 2);
+  target.close();
+  REQUIRE(std::filesystem::file_size("test.vector") == 2 * sizeof(vector_record));
+  file::remove("test.vector");
+}
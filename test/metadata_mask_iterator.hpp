@@ -0,0 +1,74 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <doctest/doctest.h>
+
+#include <iofet/metadata_mask_iterator.hpp>
+#include <iofet/file.hpp>
+
+
+namespace metadata_mask_iterator_test {
+
+  std::vector<std::string> list(std::filesystem::path const& root, std::string const& mask,
+                                iofet::metadata_filter const& filter) {
+    std::vector<std::string> result;
+    std::error_code ec;
+    std::uint64_t inode = 0;
+    for(iofet::metadata_mask_iterator it{root, mask, filter, ec}; it != end(it); ++it) {
+      REQUIRE(it->inode >= inode);
+      inode = it->inode;
+      result.push_back(std::filesystem::path{it->name}.string());
+    }
+    REQUIRE(!ec);
+    std::sort(result.begin(), result.end());
+    return result;
+  }
+
+}
+
+
+TEST_CASE("metadata_mask_iterator") {
+  namespace fs = std::filesystem;
+  using namespace metadata_mask_iterator_test;
+  using type = iofet::directory_reader::entry_type;
+  fs::path const root{"metadata.test"};
+  fs::create_directories(root / "dir.log");
+  for(int i = 0; i != 4; ++i) {
+    auto f = iofet::file::create(root / (std::to_string(i) + ".log"));
+    std::string const content(std::size_t(i) * 100, 'x');
+    REQUIRE(f.write(content.data(), content.size()));
+  }
+  iofet::file::touch(root / "other.idx");
+  auto const now = fs::last_write_time(root / "0.log");
+  fs::last_write_time(root / "3.log", now - std::chrono::hours{48});
+
+  iofet::metadata_filter filter;
+  REQUIRE(list(root, "*.log", filter) ==
+          std::vector<std::string>{"0.log", "1.log", "2.log", "3.log", "dir.log"});
+
+  filter.type = type::regular;
+  REQUIRE(list(root, "*.log", filter) ==
+          std::vector<std::string>{"0.log", "1.log", "2.log", "3.log"});
+
+  filter.min_size = 100;
+  filter.max_size = 200;
+  REQUIRE(list(root, "*.log", filter) == std::vector<std::string>{"1.log", "2.log"});
+
+  iofet::metadata_filter old;
+  old.modified_before = std::chrono::system_clock::now() - std::chrono::hours{24};
+  REQUIRE(list(root, "*", old) == std::vector<std::string>{"3.log"});
+
+  iofet::metadata_filter directories;
+  directories.type = type::directory;
+  REQUIRE(list(root, "*", directories) == std::vector<std::string>{"dir.log"});
+
+  std::error_code ec;
+  iofet::metadata_mask_iterator missing{root / "missing", "*", filter, ec};
+  REQUIRE(!!ec);
+  REQUIRE(missing == end(missing));
+  fs::remove_all(root);
+}
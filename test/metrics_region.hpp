@@ -0,0 +1,51 @@
+#pragma once
+
+#include <doctest/doctest.h>
+
+#include <iofet/file.hpp>
+#include <iofet/metrics_region.hpp>
+
+
+TEST_CASE("metrics_region::metrics_region") {
+  iofet::metrics_region target;
+  REQUIRE(!target);
+}
+
+
+TEST_CASE("metrics_region::create") {
+  using namespace iofet;
+  auto writer = metrics_region::create("test.metrics", 2);
+  REQUIRE(writer);
+  auto reads = writer.add_counter("file.reads");
+  auto latency = writer.add_histogram("file.read_latency_ns");
+  REQUIRE(reads);
+  REQUIRE(latency);
+  REQUIRE(!writer.add_counter("overflow"));
+  reads.add();
+  reads.add(2);
+  latency.record(0);
+  latency.record(700);
+  latency.record(1000);
+  
+  auto reader = metrics_region::open("test.metrics");
+  REQUIRE(reader);
+  REQUIRE(!reader.add_counter("read.only"));
+  REQUIRE(reader.size() == 2);
+  auto const counter = reader.at(0);
+  REQUIRE(counter.name == "file.reads");
+  REQUIRE(counter.kind == metrics_region::metric_kind::counter);
+  REQUIRE(counter.values[0].load() == 3);
+  auto const histogram = reader.at(1);
+  REQUIRE(histogram.name == "file.read_latency_ns");
+  REQUIRE(histogram.kind == metrics_region::metric_kind::histogram);
+  REQUIRE(histogram.size == 2 + metrics_region::histogram_buckets);
+  REQUIRE(histogram.values[0].load() == 3);
+  REQUIRE(histogram.values[1].load() == 1700);
+  REQUIRE(histogram.values[2 + 0].load() == 1);
+  REQUIRE(histogram.values[2 + 10].load() == 2);
+  REQUIRE(latency.bucket(10) == 2);
+  
+  reader = metrics_region{};
+  writer = metrics_region{};
+  file::remove("test.metrics");
+}
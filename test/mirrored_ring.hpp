@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string.h>
+#include <doctest/doctest.h>
+
+#include <iofet/mirrored_ring.hpp>
+
+
+TEST_CASE("mirrored_ring::mirrored_ring") {
+  iofet::mirrored_ring target;
+  REQUIRE(!target);
+}
+
+
+TEST_CASE("mirrored_ring::create") {
+  using namespace iofet;
+  auto target = mirrored_ring::create("test.ring", 1);
+  REQUIRE(target);
+  REQUIRE(target.capacity() == mapped_file::granularity());
+  REQUIRE(target.readable() == 0);
+  REQUIRE(target.writable() == target.capacity());
+}
+
+
+TEST_CASE("mirrored_ring::wrap") {
+  using namespace iofet;
+  auto target = mirrored_ring::open("test.ring");
+  REQUIRE(target);
+  auto const capacity = target.capacity();
+  char* head = target.prepare(capacity - 3);
+  REQUIRE(head != nullptr);
+  target.commit(capacity - 3);
+  REQUIRE(target.prepare(4) == nullptr);
+  target.consume(capacity - 3);
+  
+  // record crossing the end of the ring is still contiguous
+  REQUIRE(target.write("hello world", 11));
+  REQUIRE(target.readable() == 11);
+  REQUIRE(memcmp(target.peek(), "hello world", 11) == 0);
+  REQUIRE(target.peek() == head + capacity - 3);
+  
+  auto other = mirrored_ring::open("test.ring");
+  REQUIRE(other.readable() == 11);
+  char buffer[11];
+  REQUIRE(other.read(buffer, sizeof(buffer)));
+  REQUIRE(memcmp(buffer, "hello world", 11) == 0);
+  REQUIRE(target.readable() == 0);
+  target = mirrored_ring{};
+  other = mirrored_ring{};
+  iofet::file::remove("test.ring");
+}
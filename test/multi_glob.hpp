@@ -0,0 +1,71 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <doctest/doctest.h>
+
+#include <iofet/multi_glob.hpp>
+#include <iofet/multi_mask_iterator.hpp>
+#include <iofet/file.hpp>
+
+
+TEST_CASE("multi_glob::matches") {
+  // every mask over {a, b, *, ?} up to 4 characters compiled together,
+  // against every name over {a, b, c} up to 5 characters
+  auto const expand = [](std::string const& alphabet, std::size_t length) {
+    std::vector<std::string> result{""};
+    for(std::size_t i = 0; i != result.size(); ++i)
+      if(result[i].size() < length)
+        for(char c: alphabet)
+          result.push_back(result[i] + c);
+    return result;
+  };
+  auto const masks = expand("ab*?", 4);
+  auto const names = expand("abc", 5);
+  iofet::basic_multi_glob<char> const all{masks};
+  REQUIRE(all.size() == masks.size());
+  int mismatches = 0;
+  std::vector<std::size_t> matched;
+  for(auto const& name: names) {
+    std::vector<std::size_t> expected;
+    for(std::size_t i = 0; i != masks.size(); ++i)
+      if(iofet::detail::matched(masks[i].data(), name.data()))
+        expected.push_back(i);
+    all.matches(name, matched);
+    if(matched != expected)
+      ++mismatches;
+    if(all.matches_any(name) != !expected.empty())
+      ++mismatches;
+  }
+  REQUIRE(mismatches == 0);
+}
+
+
+TEST_CASE("multi_glob::empty") {
+  iofet::basic_multi_glob<char> const none;
+  std::vector<std::size_t> matched{1};
+  REQUIRE(!none.matches("a", matched));
+  REQUIRE(matched.empty());
+  REQUIRE(!none.matches_any("a"));
+}
+
+
+TEST_CASE("multi_mask_iterator") {
+  using namespace iofet;
+  file::touch("mseg_1.mlog");
+  file::touch("mseg_2.midx");
+  file::touch("mother.mlog");
+  std::error_code ec;
+  std::map<std::string, std::vector<std::size_t>> found;
+  for(multi_mask_iterator it{".", {"*.mlog", "*.midx", "mseg_*"}, ec}; it != end(it); ++it)
+    found[it->path().filename().string()] = it.matched();
+  REQUIRE(!ec);
+  REQUIRE(found.size() == 3);
+  REQUIRE(found["mseg_1.mlog"] == std::vector<std::size_t>{0, 2});
+  REQUIRE(found["mseg_2.midx"] == std::vector<std::size_t>{1, 2});
+  REQUIRE(found["mother.mlog"] == std::vector<std::size_t>{0});
+  file::remove("mseg_1.mlog");
+  file::remove("mseg_2.midx");
+  file::remove("mother.mlog");
+}
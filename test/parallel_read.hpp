@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string.h>
+#include <stdexcept>
+#include <vector>
+#include <doctest/doctest.h>
+
+#include <iofet/parallel_read.hpp>
+
+
+TEST_CASE("parallel_read") {
+  using namespace iofet;
+  std::vector<char> content(1000003);
+  for(size_t i = 0; i != content.size(); ++i)
+    content[i] = char(i % 253);
+  {
+    auto f = file::create("test.parallel");
+    REQUIRE(f.write(content.data(), file::size_type(content.size())));
+  }
+  auto f = file::open_to_read("test.parallel");
+  std::vector<char> buffer(content.size());
+  REQUIRE(parallel_read(f, buffer.data(), file::size_type(buffer.size()), 4, 10000));
+  REQUIRE(buffer == content);
+  REQUIRE(!parallel_read(f, buffer.data(), file::size_type(buffer.size()) + 1, 4, 10000));
+}
+
+
+TEST_CASE("parallel_read/streaming") {
+  using namespace iofet;
+  auto f = file::open_to_read("test.parallel");
+  auto const size = *f.size();
+  file::offset_type expected = 0;
+  bool intact = true;
+  bool const ok = parallel_read(f, size,
+    [&](file::offset_type offset, char const* data, file::size_type n) {
+      intact = intact && offset == expected && n <= 8192;
+      for(file::size_type i = 0; i != n; ++i)
+        intact = intact && data[i] == char((offset + i) % 253);
+      expected += n;
+      return true;
+    }, 3, 8192);
+  REQUIRE(ok);
+  REQUIRE(intact);
+  REQUIRE(expected == size);
+  
+  int calls = 0;
+  REQUIRE(!parallel_read(f, size,
+    [&](file::offset_type, char const*, file::size_type) { return ++calls < 5; },
+    3, 4096));
+  REQUIRE(calls == 5);
+
+  calls = 0;
+  REQUIRE_THROWS_AS(parallel_read(f, size,
+    [&](file::offset_type, char const*, file::size_type) -> bool {
+      if(++calls == 3)
+        throw std::runtime_error{"stop"};
+      return true;
+    }, 3, 4096), std::runtime_error);
+  REQUIRE(calls == 3);
+  f.close();
+  file::remove("test.parallel");
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <algorithm>
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <doctest/doctest.h>
+
+#include <iofet/parallel_walk.hpp>
+#include <iofet/file.hpp>
+
+
+TEST_CASE("parallel_walk") {
+  namespace fs = std::filesystem;
+  fs::path const root{"walk.test"};
+  std::vector<std::string> expected;
+  for(int i = 0; i != 8; ++i)
+    for(int j = 0; j != 8; ++j) {
+      fs::path const directory = root / std::to_string(i) / std::to_string(j);
+      fs::create_directories(directory);
+      for(int k = 0; k != 4; ++k) {
+        iofet::file::touch(directory / (std::to_string(k) + ".log"));
+        iofet::file::touch(directory / (std::to_string(k) + ".idx"));
+        expected.push_back((directory / (std::to_string(k) + ".log")).generic_string());
+      }
+    }
+  std::sort(expected.begin(), expected.end());
+
+  for(unsigned threads: {1u, 4u}) {
+    std::mutex mutex;
+    std::vector<std::string> found;
+    unsigned highest = 0;
+    REQUIRE(iofet::parallel_walk(root, "*.log",
+        [&](unsigned thread, fs::path const& directory,
+            std::vector<fs::path::string_type> const& names) {
+          std::lock_guard<std::mutex> lock{mutex};
+          highest = std::max(highest, thread);
+          for(auto const& name: names)
+            found.push_back((directory / name).generic_string());
+        }, threads));
+    std::sort(found.begin(), found.end());
+    REQUIRE(found == expected);
+    REQUIRE(highest < threads);
+  }
+
+  for(unsigned threads: {1u, 4u})
+    REQUIRE_THROWS_AS(iofet::parallel_walk(root, "*.log",
+        [](unsigned, fs::path const&, auto const&) {
+          throw std::runtime_error{"stop"};
+        }, threads), std::runtime_error);
+
+  REQUIRE(!iofet::parallel_walk(root / "missing", "*",
+                                [](unsigned, fs::path const&, auto const&) {}));
+  fs::remove_all(root);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <doctest/doctest.h>
+
+#include <iofet/recursive_mask_iterator.hpp>
+#include <iofet/file.hpp>
+
+
+namespace recursive_mask_iterator_test {
+
+  struct tree {
+    std::filesystem::path root{"recursive.test"};
+
+    tree() {
+      namespace fs = std::filesystem;
+      for(auto const* directory: {"sub/deep", ".git", "src/x", "other"})
+        fs::create_directories(root / directory);
+      for(auto const* name: {"a.log", "sub/b.log", "sub/deep/c.log", ".git/d.log",
+                             "src/x/test_1.cpp", "src/test_3.cpp", "other/test_2.cpp"})
+        iofet::file::touch(root / name);
+    }
+
+    ~tree() {
+      std::error_code ec;
+      std::filesystem::remove_all(root, ec);
+    }
+  };
+
+
+  std::vector<std::string> list(std::filesystem::path const& root, std::string const& mask,
+                                iofet::recursive_mask_iterator::options const& settings = {}) {
+    std::vector<std::string> result;
+    std::error_code ec;
+    for(iofet::recursive_mask_iterator it{root, mask, settings, ec}; it != end(it); ++it)
+      result.push_back(it->path().lexically_relative(root).generic_string());
+    std::sort(result.begin(), result.end());
+    return result;
+  }
+
+}
+
+
+TEST_CASE("recursive_mask_iterator::name") {
+  using namespace recursive_mask_iterator_test;
+  tree const t;
+  REQUIRE(list(t.root, "*.log") ==
+          std::vector<std::string>{".git/d.log", "a.log", "sub/b.log", "sub/deep/c.log"});
+}
+
+
+TEST_CASE("recursive_mask_iterator::prune") {
+  using namespace recursive_mask_iterator_test;
+  tree const t;
+  iofet::recursive_mask_iterator::options settings;
+  settings.prune = {".git"};
+  REQUIRE(list(t.root, "*.log", settings) ==
+          std::vector<std::string>{"a.log", "sub/b.log", "sub/deep/c.log"});
+  settings.max_depth = 1;
+  REQUIRE(list(t.root, "*.log", settings) ==
+          std::vector<std::string>{"a.log", "sub/b.log"});
+  settings.max_depth = 0;
+  REQUIRE(list(t.root, "*.log", settings) == std::vector<std::string>{"a.log"});
+}
+
+
+TEST_CASE("recursive_mask_iterator::path") {
+  using namespace recursive_mask_iterator_test;
+  tree const t;
+  REQUIRE(list(t.root, "src/**/test_*.cpp") ==
+          std::vector<std::string>{"src/test_3.cpp", "src/x/test_1.cpp"});
+  REQUIRE(list(t.root, "**/test_*.cpp") ==
+          std::vector<std::string>{"other/test_2.cpp", "src/test_3.cpp", "src/x/test_1.cpp"});
+  REQUIRE(list(t.root, "sub/*/c.log") == std::vector<std::string>{"sub/deep/c.log"});
+  REQUIRE(list(t.root, "*/b.log") == std::vector<std::string>{"sub/b.log"});
+}
+
+
+#ifndef _WIN32
+TEST_CASE("recursive_mask_iterator::symlink loop") {
+  using namespace recursive_mask_iterator_test;
+  tree const t;
+  std::filesystem::create_directory_symlink("..", t.root / "sub/deep/loop");
+  iofet::recursive_mask_iterator::options settings;
+  settings.directory = std::filesystem::directory_options::follow_directory_symlink;
+  REQUIRE(list(t.root, "c.log", settings) == std::vector<std::string>{"sub/deep/c.log"});
+}
+#endif // _WIN32
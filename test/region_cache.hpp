@@ -0,0 +1,62 @@
+#pragma once
+
+#include <doctest/doctest.h>
+
+#include <iofet/file.hpp>
+#include <iofet/region_cache.hpp>
+
+
+TEST_CASE("region_cache::get") {
+  using namespace iofet;
+  auto const window = mapped_file::granularity();
+  auto f = file::create("test.file");
+  f.resize(4 * window);
+  f.close();
+  auto mapped = mapped_file::open("test.file");
+  region_cache target{mapped, window, 2 * window};
+  
+  auto first = target.get(10, 4);
+  REQUIRE(first);
+  REQUIRE(first.size() == 4);
+  first.data()[0] = 'x';
+  auto again = target.get(8, 4);
+  REQUIRE(again.data() + 2 == first.data());
+  REQUIRE(target.count() == 1);
+  
+  auto straddling = target.get(window - 2, 4);
+  REQUIRE(straddling);
+  REQUIRE(target.mapped() == 2 * window);
+  REQUIRE(!target.get(4 * window - 2, 4));
+}
+
+
+TEST_CASE("region_cache::evict") {
+  using namespace iofet;
+  auto const window = mapped_file::granularity();
+  auto mapped = mapped_file::open("test.file");
+  region_cache target{mapped, window, 2 * window};
+  auto kept = target.get(0, 1);
+  target.get(window, 1);
+  target.get(2 * window, 1);
+  REQUIRE(target.count() == 2);
+  REQUIRE(target.mapped() == 2 * window);
+  // evicted window stays mapped while a view refers to it
+  kept.data()[0] = 'y';
+  target.clear();
+  REQUIRE(target.mapped() == 0);
+  REQUIRE(kept.data()[0] == 'y');
+}
+
+
+TEST_CASE("region_cache::window") {
+  using namespace iofet;
+  auto const window = mapped_file::granularity();
+  auto f = file::create("test.file");
+  f.resize(2 * window);
+  f.close();
+  auto mapped = mapped_file::open("test.file");
+  // a zero window falls back to one granularity unit
+  region_cache target{mapped, 0};
+  REQUIRE(target.window() == window);
+  REQUIRE(target.get(10, 4));
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string.h>
+#include <vector>
+#include <doctest/doctest.h>
+
+#include <iofet/file.hpp>
+#include <iofet/region_flusher.hpp>
+
+
+TEST_CASE("region_flusher::region_flusher") {
+  iofet::region_flusher target;
+  REQUIRE(!target);
+  REQUIRE(!target.flush());
+}
+
+
+TEST_CASE("region_flusher::flush") {
+  using namespace iofet;
+  auto const page = mapped_file::page_size();
+  auto f = file::create("test.file");
+  f.resize(8 * page);
+  f.close();
+  auto mapped = mapped_file::open("test.file");
+  auto region = mapped.map(0, 8 * page);
+  REQUIRE(region);
+  region_flusher target{region};
+  REQUIRE(target);
+  REQUIRE(target.write(5 * page + 1, "hello", 5));
+  REQUIRE(target.write(1, "world", 5));
+  REQUIRE(target.binary_write(page - 2, 0x01020304));
+  REQUIRE(target.dirty() == 3 * page);
+  REQUIRE(!target.write(8 * page - 2, "hello", 5));
+  REQUIRE(target.flush());
+  REQUIRE(target.dirty() == 0);
+  
+  region = mapped_file::region{};
+  auto check = file::open_to_read("test.file");
+  std::vector<char> buffer(size_t(6 * page));
+  REQUIRE(check.read(buffer.data(), 6 * page));
+  REQUIRE(memcmp(buffer.data() + 1, "world", 5) == 0);
+  REQUIRE(memcmp(buffer.data() + 5 * page + 1, "hello", 5) == 0);
+}
+
+
+TEST_CASE("region_flusher::dirty") {
+  using namespace iofet;
+  auto const page = mapped_file::page_size();
+  auto f = file::create("test.file");
+  f.resize(8 * page);
+  f.close();
+  auto mapped = mapped_file::open("test.file");
+  auto region = mapped.map(0, 8 * page);
+  REQUIRE(region);
+  region_flusher target{region};
+  // repeated writes to non-adjacent pages count each page once
+  REQUIRE(target.write(0, "a", 1));
+  REQUIRE(target.write(5 * page, "b", 1));
+  REQUIRE(target.write(1, "c", 1));
+  REQUIRE(target.write(5 * page + 1, "d", 1));
+  REQUIRE(target.dirty() == 2 * page);
+  REQUIRE(target.write(3 * page, "e", 1));
+  REQUIRE(target.dirty() == 3 * page);
+  // a range covering the gaps merges everything
+  target.mark_dirty(page, 4 * page);
+  REQUIRE(target.dirty() == 6 * page);
+  // outside the region, nothing to record
+  target.mark_dirty(8 * page, page);
+  target.mark_dirty(-1, page);
+  REQUIRE(target.dirty() == 6 * page);
+  REQUIRE(target.flush());
+  REQUIRE(target.dirty() == 0);
+}
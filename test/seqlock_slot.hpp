@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <doctest/doctest.h>
+
+#include <iofet/mapped_file.hpp>
+#include <iofet/seqlock_slot.hpp>
+
+
+namespace {
+
+  struct seqlock_state {
+    int values[1024];
+  };
+
+}
+
+
+TEST_CASE("seqlock_slot::load") {
+  using namespace iofet;
+  using slot_type = seqlock_slot<seqlock_state>;
+  auto memory = mapped_file::anonymous(sizeof(slot_type));
+  auto writer_region = memory.map();
+  // readers see the slot through a view of their own, as another process would
+  auto reader_region = memory.map();
+  REQUIRE(writer_region);
+  REQUIRE(reader_region);
+  auto* const writer = slot_type::create(writer_region.address);
+  auto const* const reader = slot_type::attach(reader_region.address);
+  REQUIRE(reader->version() == 0);
+  
+  constexpr int updates = 20000;
+  std::atomic<bool> consistent{true};
+  std::thread writing([&] {
+    seqlock_state state;
+    for(int i = 1; i <= updates; ++i) {
+      for(auto& value: state.values)
+        value = i;
+      writer->store(state);
+    }
+  });
+  std::vector<std::thread> readers;
+  for(int r = 0; r != 2; ++r)
+    readers.emplace_back([&] {
+      int last = 0;
+      while(last != updates) {
+        auto const state = reader->load();
+        for(auto value: state.values)
+          if(value != state.values[0])
+            consistent = false;
+        if(state.values[0] < last)
+          consistent = false;
+        last = state.values[0];
+      }
+    });
+  writing.join();
+  for(auto& thread: readers)
+    thread.join();
+  REQUIRE(consistent);
+  REQUIRE(reader->version() == updates);
+}
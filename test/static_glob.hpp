@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+#include <doctest/doctest.h>
+
+#include <iofet/static_glob.hpp>
+#include <iofet/directory_mask_iterator.hpp>
+#include <iofet/file.hpp>
+
+
+namespace static_glob_test {
+
+  static constexpr char empty[] = "";
+  static constexpr char exact[] = "ab?a";
+  static constexpr char prefix[] = "ab*";
+  static constexpr char suffix[] = "*?b";
+  static constexpr char contains[] = "*ab*";
+  static constexpr char general[] = "a*b?*a";
+  static constexpr char stars[] = "**";
+  static constexpr char log_mask[] = "*.1";
+
+
+  template<char const* Mask>
+  int mismatches(std::vector<std::string> const& names) {
+    int result = 0;
+    for(auto const& name: names)
+      if(iofet::static_glob<Mask>::matches(name.c_str()) != iofet::detail::matched(Mask, name.c_str()))
+        ++result;
+    return result;
+  }
+
+}
+
+
+TEST_CASE("static_glob::matches") {
+  using namespace static_glob_test;
+  std::vector<std::string> names{""};
+  for(std::size_t i = 0; i != names.size(); ++i)
+    if(names[i].size() < 6)
+      for(char c: {'a', 'b'})
+        names.push_back(names[i] + c);
+  REQUIRE(mismatches<empty>(names) == 0);
+  REQUIRE(mismatches<exact>(names) == 0);
+  REQUIRE(mismatches<prefix>(names) == 0);
+  REQUIRE(mismatches<suffix>(names) == 0);
+  REQUIRE(mismatches<contains>(names) == 0);
+  REQUIRE(mismatches<general>(names) == 0);
+  REQUIRE(mismatches<stars>(names) == 0);
+  REQUIRE(iofet::static_glob<log_mask>::matches(std::string_view{"a.1"}));
+  REQUIRE(!iofet::static_glob<log_mask>::matches(std::string_view{"a.12"}));
+}
+
+
+TEST_CASE("static_directory_mask_iterator") {
+  using namespace iofet;
+  std::filesystem::path const root{"static_glob.test"};
+  std::filesystem::create_directories(root);
+  for(auto const* name: {"a.1", "b.1", "c.2", "d.12", "e.1x"})
+    file::touch(root / name);
+  std::error_code ec;
+  std::vector<std::string> dynamic, fixed;
+  for(directory_mask_iterator it{root, "*.1", ec}; it != end(it); ++it)
+    dynamic.push_back(it->path().filename().string());
+  REQUIRE(!ec);
+  for(static_directory_mask_iterator<static_glob_test::log_mask> it{root, ec}; it != end(it); ++it)
+    fixed.push_back(it->path().filename().string());
+  REQUIRE(!ec);
+  std::sort(dynamic.begin(), dynamic.end());
+  std::sort(fixed.begin(), fixed.end());
+  REQUIRE(fixed == std::vector<std::string>{"a.1", "b.1"});
+  REQUIRE(dynamic == fixed);
+  std::filesystem::remove_all(root);
+}
@@ -4,3 +4,23 @@
 #include "file.hpp"
 #include "mapped_file.hpp"
 #include "directory_mask_iterator.hpp"
+#include "growable_mapping.hpp"
+#include "window_mapper.hpp"
+#include "region_flusher.hpp"
+#include "region_cache.hpp"
+#include "mirrored_ring.hpp"
+#include "mapped_queue.hpp"
+#include "mapped_arena.hpp"
+#include "mapped_vector.hpp"
+#include "seqlock_slot.hpp"
+#include "metrics_region.hpp"
+#include "auto_reader.hpp"
+#include "parallel_read.hpp"
+#include "glob.hpp"
+#include "static_glob.hpp"
+#include "multi_glob.hpp"
+#include "recursive_mask_iterator.hpp"
+#include "parallel_walk.hpp"
+#include "directory_reader.hpp"
+#include "metadata_mask_iterator.hpp"
+#include "dir_snapshot.hpp"
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string.h>
+#include <filesystem>
+#include <doctest/doctest.h>
+
+#include <iofet/file.hpp>
+#include <iofet/window_mapper.hpp>
+
+
+TEST_CASE("window_mapper::window_mapper") {
+  iofet::window_mapper target;
+  REQUIRE(!target);
+}
+
+
+TEST_CASE("window_mapper::advance") {
+  using namespace iofet;
+  auto const size = 5 * mapped_file::granularity() + 100;
+  auto f = file::create("test.file");
+  for(auto i = 0; i != size; ++i)
+    f.binary_write(char(i % 251));
+  f.close();
+  
+  auto target = window_mapper::open("test.file", 2 * mapped_file::granularity());
+  REQUIRE(target);
+  REQUIRE(target.size() == size);
+  window_mapper::size_type consumed = 0;
+  bool intact = true;
+  while(!target.eof()) {
+    auto const available = target.available();
+    REQUIRE(available > 0);
+    REQUIRE(available <= target.window());
+    for(auto i = 0; i != available; ++i)
+      intact = intact && target.data()[i] == char((consumed + i) % 251);
+    consumed += available;
+    REQUIRE(target.advance(available));
+  }
+  REQUIRE(intact);
+  REQUIRE(consumed == size);
+  REQUIRE(target.data() == nullptr);
+}
+
+
+TEST_CASE("window_mapper::seek") {
+  using namespace iofet;
+  auto target = window_mapper::open("test.file", mapped_file::granularity());
+  REQUIRE(target.seek(3 * mapped_file::granularity() + 7));
+  REQUIRE(*target.data() == char((3 * mapped_file::granularity() + 7) % 251));
+  REQUIRE(target.available() == mapped_file::granularity() - 7);
+  REQUIRE(!target.seek(target.size() + 1));
+}
+
+
+TEST_CASE("window_mapper::open empty window") {
+  using namespace iofet;
+  REQUIRE(!window_mapper::open("test.file", 0));
+  REQUIRE(!window_mapper::open("test.file", -1));
+}
+
+
+TEST_CASE("window_mapper::open read only") {
+  using namespace iofet;
+  namespace fs = std::filesystem;
+  {
+    auto f = file::create("readonly.file");
+    REQUIRE(f.write("archive", 7));
+  }
+  fs::permissions("readonly.file", fs::perms::owner_read | fs::perms::group_read |
+                                   fs::perms::others_read);
+  auto target = window_mapper::open("readonly.file");
+  REQUIRE(target);
+  REQUIRE(target.available() == 7);
+  REQUIRE(memcmp(target.data(), "archive", 7) == 0);
+  REQUIRE(target.position() == 0);
+  target = window_mapper{};
+  fs::permissions("readonly.file", fs::perms::owner_write, fs::perm_options::add);
+  file::remove("readonly.file");
+}
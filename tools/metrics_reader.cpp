@@ -0,0 +1,61 @@
+// Prints metrics of a running process from its metrics_region file
+//
+//   metrics_reader <file> [interval in ms]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+#include <iofet/metrics_region.hpp>
+
+
+void print(iofet::metrics_region const& metrics) {
+  using iofet::metrics_region;
+  for(std::uint32_t i = 0; i != metrics.size(); ++i) {
+    auto const entry = metrics.at(i);
+    std::cout << entry.name;
+    if(entry.kind == metrics_region::metric_kind::counter) {
+      std::cout << ' ' << entry.values[0].load(std::memory_order_relaxed) << '\n';
+      continue;
+    }
+    auto const count = entry.values[0].load(std::memory_order_relaxed);
+    auto const sum = entry.values[1].load(std::memory_order_relaxed);
+    std::cout << " count=" << count << " sum=" << sum;
+    if(count != 0)
+      std::cout << " mean=" << double(sum) / double(count);
+    for(std::uint32_t b = 0; b != metrics_region::histogram_buckets; ++b) {
+      auto const n = entry.values[2 + b].load(std::memory_order_relaxed);
+      if(n == 0)
+        continue;
+      // bucket b holds values below 2^b
+      std::cout << " <2^" << b << ':' << n;
+    }
+    std::cout << '\n';
+  }
+  std::cout << std::flush;
+}
+
+
+int main(int argc, char** argv) {
+  if(argc < 2) {
+    std::cerr << "usage: " << argv[0] << " <file> [interval in ms]" << std::endl;
+    return 2;
+  }
+  auto const metrics = iofet::metrics_region::open(argv[1]);
+  if(!metrics) {
+    std::cerr << argv[1] << ": " << iofet::metrics_region::last_error().message()
+              << std::endl;
+    return 1;
+  }
+  if(argc < 3) {
+    print(metrics);
+    return 0;
+  }
+  std::chrono::milliseconds const interval{std::atoi(argv[2])};
+  for(;;) {
+    print(metrics);
+    std::cout << '\n';
+    std::this_thread::sleep_for(interval);
+  }
+}